@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "core/event_recorder.h"
+
+class Plugin_Base;
+class StandInHost;
+
+// Feeds a trace written by EventRecorder back through a Plugin_Base as fast as possible,
+// keeping the StandInHost state in step, and accounts the time spent per event type.
+class EventReplay
+{
+
+public:
+    struct Stats
+    {
+        quint64 count = 0;
+        qint64 total_ns = 0;
+        qint64 max_ns = 0;
+    };
+
+    EventReplay(Plugin_Base& plugin, StandInHost& host);
+
+    bool run(const QString& file_path);
+    const Stats& stats(EventTrace::Type type) const { return m_stats[static_cast<size_t>(type)]; }
+    qint64 total_ns() const { return m_total_ns; }
+    QString report() const;
+
+private:
+    Plugin_Base& m_plugin;
+    StandInHost& m_host;
+
+    std::array<Stats, static_cast<size_t>(EventTrace::Type::Count)> m_stats;
+    qint64 m_total_ns = 0;
+    QVector<short> m_samples;
+
+    void account(EventTrace::Type type, qint64 elapsed_ns);
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <random>
+
+#include <QtCore/QMap>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "teamspeak/public_definitions.h"
+
+class Plugin_Base;
+class TSServersInfo;
+class StandInHost;
+
+// Something under load; receives the synthetic events the generator produces.
+// All handlers run on the generator thread and are timed individually.
+class LoadComponent
+{
+public:
+    virtual ~LoadComponent() = default;
+
+    virtual QString name() const = 0;
+    virtual void on_connect_status(uint64 sch_id, int new_status) { Q_UNUSED(sch_id); Q_UNUSED(new_status); }
+    virtual void on_client_move(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility) { Q_UNUSED(sch_id); Q_UNUSED(client_id); Q_UNUSED(old_channel_id); Q_UNUSED(new_channel_id); Q_UNUSED(visibility); }
+    virtual void on_talk_status(uint64 sch_id, anyID client_id, int status, int is_whisper) { Q_UNUSED(sch_id); Q_UNUSED(client_id); Q_UNUSED(status); Q_UNUSED(is_whisper); }
+    virtual void on_server_group(uint64 sch_id, uint64 server_group_id, const char* name) { Q_UNUSED(sch_id); Q_UNUSED(server_group_id); Q_UNUSED(name); }
+    virtual void on_server_group_list_finished(uint64 sch_id) { Q_UNUSED(sch_id); }
+    virtual void on_client_groups_changed(uint64 sch_id, anyID client_id) { Q_UNUSED(sch_id); Q_UNUSED(client_id); }
+    virtual void on_voice(uint64 sch_id, anyID client_id, short* samples, int frame_count, int channels) { Q_UNUSED(sch_id); Q_UNUSED(client_id); Q_UNUSED(samples); Q_UNUSED(frame_count); Q_UNUSED(channels); }
+    virtual void on_tick(uint64 sch_id, anyID some_client_id, uint64 some_channel_id) { Q_UNUSED(sch_id); Q_UNUSED(some_client_id); Q_UNUSED(some_channel_id); }
+};
+
+// Plugin_Base and therefore Talkers, TSInfoData etc.
+class PluginLoadComponent : public LoadComponent
+{
+public:
+    explicit PluginLoadComponent(Plugin_Base& plugin) : m_plugin(plugin) {}
+
+    QString name() const override { return "plugin"; }
+    void on_connect_status(uint64 sch_id, int new_status) override;
+    void on_client_move(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility) override;
+    void on_talk_status(uint64 sch_id, anyID client_id, int status, int is_whisper) override;
+    void on_server_group(uint64 sch_id, uint64 server_group_id, const char* name) override;
+    void on_server_group_list_finished(uint64 sch_id) override;
+    void on_client_groups_changed(uint64 sch_id, anyID client_id) override;
+    void on_voice(uint64 sch_id, anyID client_id, short* samples, int frame_count, int channels) override;
+
+private:
+    Plugin_Base& m_plugin;
+};
+
+class ServersInfoLoadComponent : public LoadComponent
+{
+public:
+    explicit ServersInfoLoadComponent(TSServersInfo& servers_info) : m_servers_info(servers_info) {}
+
+    QString name() const override { return "servers_info"; }
+    void on_connect_status(uint64 sch_id, int new_status) override;
+    void on_server_group(uint64 sch_id, uint64 server_group_id, const char* name) override;
+    void on_server_group_list_finished(uint64 sch_id) override;
+    void on_tick(uint64 sch_id, anyID some_client_id, uint64 some_channel_id) override;
+
+private:
+    TSServersInfo& m_servers_info;
+};
+
+// A sample of the TSHelpers lookups plugins typically do on user interaction
+class HelpersLoadComponent : public LoadComponent
+{
+public:
+    QString name() const override { return "helpers"; }
+    void on_tick(uint64 sch_id, anyID some_client_id, uint64 some_channel_id) override;
+};
+
+// Simulates N server tabs with M clients each against the StandInHost,
+// drives talk duty cycles, move churn, group changes and voice buffers through the components,
+// and reports per component cpu time, event handling latency (wall time) and memory growth.
+class LoadGenerator
+{
+
+public:
+    struct Config
+    {
+        int servers = 1;
+        int clients = 100;              // per server, not counting ourselves
+        int channels = 50;              // per server
+        int server_groups = 20;         // per server; each client is member of 1-3
+        int ticks = 500;                // a tick is one voice block
+        double talk_duty = 0.1;         // fraction of time a client is talking
+        int talk_burst_ticks = 150;     // mean length of a talk burst
+        double move_rate = 0.002;       // chance per client and tick to switch channels
+        double group_change_rate = 0.0005;  // chance per client and tick to get a server group added or removed
+        int frame_count = 480;
+        int channels_per_frame = 1;
+        quint32 seed = 1;
+    };
+
+    struct Result
+    {
+        struct Component
+        {
+            QString name;
+            quint64 events = 0;
+            qint64 cpu_ns = 0;          // thread cpu time
+            qint64 total_ns = 0;        // wall time, as the latencies
+            qint64 max_ns = 0;
+            qint64 p50_ns = 0;
+            qint64 p99_ns = 0;
+        };
+
+        int servers = 0;
+        int clients = 0;
+        quint64 api_calls = 0;
+        qint64 cpu_ns = 0;          // whole run, generator included
+        qint64 memory_growth = 0;   // resident bytes, after disconnect vs. before connect
+        qint64 memory_peak_growth = 0;  // resident bytes, before disconnect vs. before connect
+        QVector<Component> components;
+    };
+
+    explicit LoadGenerator(StandInHost& host);
+
+    void add_component(LoadComponent* component);  // not owned
+
+    Result run(const Config& config);
+    QVector<Result> sweep(Config config, const QVector<int>& servers, const QVector<int>& clients);
+    static QString report(const QVector<Result>& results);
+
+private:
+    // log2 buckets of event latency in ns
+    using Histogram = std::array<quint64, 40>;
+
+    struct Timing
+    {
+        quint64 events = 0;
+        qint64 cpu_ns = 0;
+        qint64 total_ns = 0;
+        qint64 max_ns = 0;
+        Histogram histogram{};
+    };
+
+    StandInHost& m_host;
+    QVector<LoadComponent*> m_components;
+    QVector<Timing> m_timings;
+    std::mt19937 m_random;
+    QVector<short> m_signal;
+    QVector<short> m_buffer;
+
+    template <typename F> void dispatch(F f);
+    void connect_server(const Config& config, uint64 sch_id);
+    void disconnect_server(uint64 sch_id);
+    void tick(const Config& config, uint64 sch_id, int tick);
+    bool chance(double p);
+    int pick(int count);
+
+    static qint64 resident_bytes();
+    static qint64 thread_cpu_ns();
+    static qint64 percentile(const Histogram& histogram, quint64 events, double p);
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+#include "teamspeak/public_definitions.h"
+#include "plugin_definitions.h"
+
+// A minimal in-process replacement for the TeamSpeak client, answering the subset of ts3Functions
+// the common classes use from a scripted server/client/channel state.
+// Used by the replay and load generator harnesses; not thread-safe, drive it from one thread.
+class StandInHost
+{
+
+public:
+    struct Client
+    {
+        uint64 channel_id = 0;
+        int talking = STATUS_NOT_TALKING;
+        int whispering = 0;
+        int type = 0;
+        int channel_group_id = 0;
+        int channel_commander = 0;
+        QByteArray server_groups;   // comma separated, as CLIENT_SERVERGROUPS
+        QByteArray nickname;
+        QByteArray unique_id;
+    };
+
+    struct Channel
+    {
+        uint64 parent_id = 0;
+        uint64 order = 0;
+        QByteArray name;
+    };
+
+    struct Server
+    {
+        int status = STATUS_DISCONNECTED;
+        anyID my_id = 0;
+        QByteArray name;
+        QByteArray unique_id;
+        uint64 default_channel_group = 0;
+        QHash<anyID, Client> clients;
+        QMap<uint64, Channel> channels;
+    };
+
+    static StandInHost* instance();
+
+    // Points ts3Functions to this host
+    void install();
+    void reset();
+
+    Server& server(uint64 sch_id);
+    void remove_server(uint64 sch_id);
+    void set_current_server(uint64 sch_id) { m_current = sch_id; }
+    void set_config_path(const QString& path) { m_config_path = path.toLocal8Bit(); }
+    void set_verbose(bool val) { m_is_verbose = val; }
+
+    void set_connection_status(uint64 sch_id, int status);
+    void set_my_id(uint64 sch_id, anyID my_id);
+    void add_channel(uint64 sch_id, uint64 channel_id, uint64 parent_id, const QByteArray& name);
+    void move_client(uint64 sch_id, anyID client_id, uint64 channel_id);   // channel 0 removes the client
+    void set_talk_status(uint64 sch_id, anyID client_id, int status, int is_whispering);
+
+    // Amount of ts3Functions calls served; the cross-dll boundary is what we try to avoid
+    quint64 api_calls() const { return m_api_calls.load(std::memory_order_relaxed); }
+    void reset_api_calls() { m_api_calls.store(0, std::memory_order_relaxed); }
+
+private:
+    StandInHost() = default;
+
+    QMap<uint64, Server> m_servers;
+    uint64 m_current = 0;
+    QByteArray m_config_path;
+    bool m_is_verbose = false;
+    std::atomic<quint64> m_api_calls{0};
+
+    void count() { m_api_calls.fetch_add(1, std::memory_order_relaxed); }
+    Server* find_server(uint64 sch_id);
+    Client* find_client(uint64 sch_id, anyID client_id);
+
+    // ts3Functions
+    static unsigned int freeMemory(void* pointer);
+    static unsigned int logMessage(const char* log_message, enum LogLevel severity, const char* channel, uint64 log_id);
+    static unsigned int getErrorMessage(unsigned int error_code, char** error);
+    static unsigned int getConnectionStatus(uint64 sch_id, int* result);
+    static unsigned int getClientID(uint64 sch_id, anyID* result);
+    static unsigned int getClientSelfVariableAsInt(uint64 sch_id, size_t flag, int* result);
+    static unsigned int getClientVariableAsInt(uint64 sch_id, anyID client_id, size_t flag, int* result);
+    static unsigned int getClientVariableAsString(uint64 sch_id, anyID client_id, size_t flag, char** result);
+    static unsigned int getClientList(uint64 sch_id, anyID** result);
+    static unsigned int getChannelOfClient(uint64 sch_id, anyID client_id, uint64* result);
+    static unsigned int getChannelVariableAsString(uint64 sch_id, uint64 channel_id, size_t flag, char** result);
+    static unsigned int getChannelVariableAsUInt64(uint64 sch_id, uint64 channel_id, size_t flag, uint64* result);
+    static unsigned int getChannelIDFromChannelNames(uint64 sch_id, char** channel_name_array, uint64* result);
+    static unsigned int getChannelList(uint64 sch_id, uint64** result);
+    static unsigned int getChannelClientList(uint64 sch_id, uint64 channel_id, anyID** result);
+    static unsigned int getParentChannelOfChannel(uint64 sch_id, uint64 channel_id, uint64* result);
+    static unsigned int getServerConnectionHandlerList(uint64** result);
+    static unsigned int getServerVariableAsString(uint64 sch_id, size_t flag, char** result);
+    static unsigned int getServerVariableAsUInt64(uint64 sch_id, size_t flag, uint64* result);
+    static unsigned int isWhispering(uint64 sch_id, anyID client_id, int* result);
+    static unsigned int getClientDisplayName(uint64 sch_id, anyID client_id, char* result, size_t max_len);
+    static unsigned int requestClientSetWhisperList(uint64 sch_id, anyID client_id, const uint64* target_channel_ids, const anyID* target_client_ids, const char* return_code);
+    static unsigned int requestClientVariables(uint64 sch_id, anyID client_id, const char* return_code);
+    static unsigned int printMessage(uint64 sch_id, const char* message, enum PluginMessageTarget message_target);
+    static unsigned int playWaveFile(uint64 sch_id, const char* path);
+    static uint64 getCurrentServerConnectionHandlerID();
+    static void requestInfoUpdate(uint64 sch_id, enum PluginItemType item_type, uint64 item_id);
+    static void getResourcesPath(char* path, size_t max_len);
+    static void getConfigPath(char* path, size_t max_len);
+};
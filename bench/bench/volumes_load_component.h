@@ -0,0 +1,21 @@
+#pragma once
+
+#include "bench/load_generator.h"
+
+class Volumes;
+
+// Volumes creates a DspVolume per talker and processes its voice buffers.
+// Note Volumes expects to have a parent when deleting volumes.
+class VolumesLoadComponent : public LoadComponent
+{
+public:
+    explicit VolumesLoadComponent(Volumes& volumes) : m_volumes(volumes) {}
+
+    QString name() const override { return "volumes"; }
+    void on_connect_status(uint64 sch_id, int new_status) override;
+    void on_talk_status(uint64 sch_id, anyID client_id, int status, int is_whisper) override;
+    void on_voice(uint64 sch_id, anyID client_id, short* samples, int frame_count, int channels) override;
+
+private:
+    Volumes& m_volumes;
+};
@@ -0,0 +1,295 @@
+#include "bench/event_replay.h"
+
+#include <algorithm>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+#include "teamspeak/public_definitions.h"
+
+#include "core/plugin_base.h"
+#include "core/ts_logging_qt.h"
+#include "bench/stand_in_host.h"
+
+namespace {
+
+    struct Record
+    {
+        EventTrace::Type type;
+        quint64 sch_id = 0;
+        qint32 status = 0;      // new_status, talk status, visibility, frame_count
+        qint32 extra = 0;       // error_number, is_received_whisper, group type, channels
+        quint16 client_id = 0;
+        quint16 other_id = 0;   // mover id
+        quint64 old_id = 0;     // old channel id, group id
+        quint64 new_id = 0;     // new channel id
+        QByteArray name;
+        int sample_offset = -1;
+        bool is_skipped = false;
+    };
+
+    bool read_trace(const QString& file_path, QVector<Record>& records, QVector<short>& samples)
+    {
+        QFile file(file_path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            TS_ERROR(QString("(EventReplay) Could not open %1: %2").arg(file_path).arg(file.errorString()), true);
+            return false;
+        }
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_5_0);
+
+        quint32 magic;
+        quint16 version;
+        quint8 voice;
+        in >> magic >> version >> voice;
+        if (magic != EventTrace::kMagic || version != EventTrace::kVersion)
+        {
+            TSLogging::Error("(EventReplay) Not a trace file or unsupported version.", true);
+            return false;
+        }
+
+        while (!in.atEnd())
+        {
+            quint8 type;
+            quint64 nsecs;
+            Record r;
+            in >> type >> nsecs >> r.sch_id;
+            r.type = static_cast<EventTrace::Type>(type);
+            switch (r.type)
+            {
+            case EventTrace::Type::ConnectStatus:
+                in >> r.status >> r.extra;
+                break;
+            case EventTrace::Type::Identity:
+                in >> r.client_id >> r.new_id;
+                break;
+            case EventTrace::Type::ClientMove:
+            case EventTrace::Type::ClientMoveTimeout:
+                in >> r.client_id >> r.old_id >> r.new_id >> r.status;
+                break;
+            case EventTrace::Type::ClientMoveMoved:
+                in >> r.client_id >> r.old_id >> r.new_id >> r.status >> r.other_id;
+                break;
+            case EventTrace::Type::TalkStatus:
+                in >> r.status >> r.extra >> r.client_id;
+                break;
+            case EventTrace::Type::ServerGroupList:
+            case EventTrace::Type::ChannelGroupList:
+                in >> r.old_id >> r.name >> r.extra;
+                break;
+            case EventTrace::Type::ServerGroupListFinished:
+            case EventTrace::Type::ChannelGroupListFinished:
+                break;
+            case EventTrace::Type::PlaybackPreProcess:
+            case EventTrace::Type::PlaybackPostProcess:
+                in >> r.client_id >> r.status >> r.extra;
+                if (static_cast<EventTrace::Voice>(voice) == EventTrace::Voice::Samples)
+                {
+                    // bounded like the recorder's buffers, so a corrupt count can't make us allocate
+                    const auto kCount = static_cast<qint64>(r.status) * r.extra;
+                    if (r.status < 0 || r.extra < 0 || kCount > EventRecorder::kVoiceMaxSamples)
+                    {
+                        TS_ERROR(QString("(EventReplay) Invalid sample count %1x%2; corrupt trace.").arg(r.status).arg(r.extra), true);
+                        return false;
+                    }
+                    r.sample_offset = samples.size();
+                    samples.resize(samples.size() + static_cast<int>(kCount));
+                    in.readRawData(reinterpret_cast<char*>(samples.data() + r.sample_offset), static_cast<int>(kCount) * static_cast<int>(sizeof(short)));
+                }
+                break;
+            default:
+                TS_ERROR(QString("(EventReplay) Unknown record type %1; stopping read.").arg(type), true);
+                return !records.isEmpty();
+            }
+            if (in.status() != QDataStream::Ok)
+                break;
+
+            records.append(r);
+        }
+        return true;
+    }
+
+    // On connection established, Plugin_Base looks up our id and fakes a move of ourselves into our channel.
+    // The host needs to know about us before the connect event is dispatched, and the recorded fake move
+    // must not be dispatched a second time.
+    void resolve_identities(QVector<Record>& records)
+    {
+        for (int i = 0; i < records.size(); ++i)
+        {
+            auto& r = records[i];
+            if (r.type != EventTrace::Type::ConnectStatus || r.status != STATUS_CONNECTION_ESTABLISHED)
+                continue;
+
+            for (int j = i + 1; j < records.size(); ++j)
+            {
+                auto& identity = records[j];
+                if (identity.sch_id != r.sch_id || identity.type != EventTrace::Type::Identity)
+                    continue;
+
+                r.client_id = identity.client_id;
+                r.new_id = identity.new_id;
+                identity.is_skipped = true;
+                for (int k = j + 1; k < records.size(); ++k)
+                {
+                    auto& move = records[k];
+                    if (move.sch_id == r.sch_id && move.type == EventTrace::Type::ClientMove && move.client_id == identity.client_id && move.old_id == 0)
+                    {
+                        move.is_skipped = true;
+                        break;
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+EventReplay::EventReplay(Plugin_Base& plugin, StandInHost& host)
+    : m_plugin(plugin)
+    , m_host(host)
+{}
+
+//! Replay a trace
+/*!
+ * \brief EventReplay::run the trace is loaded into memory up front, so only the dispatch is timed
+ * \param file_path the trace file
+ * \return true on success
+ */
+bool EventReplay::run(const QString& file_path)
+{
+    QVector<Record> records;
+    QVector<short> samples;
+    if (!read_trace(file_path, records, samples))
+        return false;
+
+    resolve_identities(records);
+
+    QVector<unsigned int> speakers;
+    QElapsedTimer timer;
+    for (const auto& r : records)
+    {
+        if (r.is_skipped)
+            continue;
+
+        switch (r.type)
+        {
+        case EventTrace::Type::ConnectStatus:
+            m_host.set_connection_status(r.sch_id, r.status);
+            if (r.status == STATUS_CONNECTION_ESTABLISHED && r.client_id)
+            {
+                m_host.set_my_id(r.sch_id, r.client_id);
+                m_host.move_client(r.sch_id, r.client_id, r.new_id);
+            }
+            timer.start();
+            m_plugin.onConnectStatusChangeEvent(r.sch_id, r.status, r.extra);
+            account(r.type, timer.nsecsElapsed());
+            break;
+        case EventTrace::Type::ClientMove:
+        case EventTrace::Type::ClientMoveTimeout:
+        case EventTrace::Type::ClientMoveMoved:
+            if (r.new_id != 0)
+                m_host.move_client(r.sch_id, r.client_id, r.new_id);
+
+            timer.start();
+            if (r.type == EventTrace::Type::ClientMove)
+                m_plugin.onClientMoveEvent(r.sch_id, r.client_id, r.old_id, r.new_id, r.status, "");
+            else if (r.type == EventTrace::Type::ClientMoveTimeout)
+                m_plugin.onClientMoveTimeoutEvent(r.sch_id, r.client_id, r.old_id, r.new_id, r.status, "");
+            else
+                m_plugin.onClientMoveMovedEvent(r.sch_id, r.client_id, r.old_id, r.new_id, r.status, r.other_id, "", "", "");
+
+            account(r.type, timer.nsecsElapsed());
+            if (r.new_id == 0)
+                m_host.move_client(r.sch_id, r.client_id, 0);
+
+            break;
+        case EventTrace::Type::TalkStatus:
+            m_host.set_talk_status(r.sch_id, r.client_id, r.status, r.extra);
+            timer.start();
+            m_plugin.onTalkStatusChangeEvent(r.sch_id, r.status, r.extra, r.client_id);
+            account(r.type, timer.nsecsElapsed());
+            break;
+        case EventTrace::Type::ServerGroupList:
+            timer.start();
+            m_plugin.onServerGroupListEvent(r.sch_id, r.old_id, r.name.constData(), r.extra, 0, 0);
+            account(r.type, timer.nsecsElapsed());
+            break;
+        case EventTrace::Type::ServerGroupListFinished:
+            timer.start();
+            m_plugin.onServerGroupListFinishedEvent(r.sch_id);
+            account(r.type, timer.nsecsElapsed());
+            break;
+        case EventTrace::Type::ChannelGroupList:
+            timer.start();
+            m_plugin.onChannelGroupListEvent(r.sch_id, r.old_id, r.name.constData(), r.extra, 0, 0);
+            account(r.type, timer.nsecsElapsed());
+            break;
+        case EventTrace::Type::ChannelGroupListFinished:
+            timer.start();
+            m_plugin.onChannelGroupListFinishedEvent(r.sch_id);
+            account(r.type, timer.nsecsElapsed());
+            break;
+        case EventTrace::Type::PlaybackPreProcess:
+        case EventTrace::Type::PlaybackPostProcess:
+        {
+            // plugins edit the buffer in place, so every event gets a fresh copy
+            const auto kCount = r.status * r.extra;
+            m_samples.resize(kCount);
+            if (r.sample_offset >= 0)
+                std::copy(samples.constBegin() + r.sample_offset, samples.constBegin() + r.sample_offset + kCount, m_samples.begin());
+            else
+                m_samples.fill(0);
+
+            timer.start();
+            if (r.type == EventTrace::Type::PlaybackPreProcess)
+                m_plugin.onEditPlaybackVoiceDataEvent(r.sch_id, r.client_id, m_samples.data(), r.status, r.extra);
+            else
+            {
+                speakers.fill(0, r.extra);
+                unsigned int fill_mask = 0;
+                m_plugin.onEditPostProcessVoiceDataEvent(r.sch_id, r.client_id, m_samples.data(), r.status, r.extra, speakers.constData(), &fill_mask);
+            }
+            account(r.type, timer.nsecsElapsed());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+QString EventReplay::report() const
+{
+    QString result;
+    QTextStream out(&result);
+    out << QString("%1 %2 %3 %4 %5\n")
+           .arg("event", -28).arg("count", 10).arg("total ms", 12).arg("avg us", 10).arg("max us", 10);
+    for (size_t i = 0; i < m_stats.size(); ++i)
+    {
+        const auto& stats = m_stats[i];
+        if (stats.count == 0)
+            continue;
+
+        out << QString("%1 %2 %3 %4 %5\n")
+               .arg(EventTrace::type_name(static_cast<EventTrace::Type>(i)), -28)
+               .arg(stats.count, 10)
+               .arg(stats.total_ns / 1e6, 12, 'f', 3)
+               .arg(stats.total_ns / 1e3 / stats.count, 10, 'f', 3)
+               .arg(stats.max_ns / 1e3, 10, 'f', 3);
+    }
+    out << QString("total %1 ms, %2 api calls\n").arg(m_total_ns / 1e6, 0, 'f', 3).arg(m_host.api_calls());
+    return result;
+}
+
+void EventReplay::account(EventTrace::Type type, qint64 elapsed_ns)
+{
+    auto& stats = m_stats[static_cast<size_t>(type)];
+    ++stats.count;
+    stats.total_ns += elapsed_ns;
+    stats.max_ns = qMax(stats.max_ns, elapsed_ns);
+    m_total_ns += elapsed_ns;
+}
@@ -0,0 +1,460 @@
+#include "bench/load_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtCore/QByteArrayList>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <QtCore/QtGlobal>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "teamspeak/public_rare_definitions.h"
+
+#include "core/plugin_base.h"
+#include "core/ts_helpers_qt.h"
+#include "core/ts_serversinfo.h"
+#include "bench/stand_in_host.h"
+
+namespace {
+
+    const anyID kMyId = 1;
+    const double kPi = 3.14159265358979323846;
+
+    QString server_unique_id(uint64 sch_id)
+    {
+        return QString("bench-%1=").arg(sch_id);
+    }
+}
+
+// PluginLoadComponent
+
+void PluginLoadComponent::on_connect_status(uint64 sch_id, int new_status)
+{
+    m_plugin.onConnectStatusChangeEvent(sch_id, new_status, 0);
+}
+
+void PluginLoadComponent::on_client_move(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility)
+{
+    m_plugin.onClientMoveEvent(sch_id, client_id, old_channel_id, new_channel_id, visibility, "");
+}
+
+void PluginLoadComponent::on_talk_status(uint64 sch_id, anyID client_id, int status, int is_whisper)
+{
+    m_plugin.onTalkStatusChangeEvent(sch_id, status, is_whisper, client_id);
+}
+
+void PluginLoadComponent::on_server_group(uint64 sch_id, uint64 server_group_id, const char* name)
+{
+    m_plugin.onServerGroupListEvent(sch_id, server_group_id, name, 1, 0, 0);
+}
+
+void PluginLoadComponent::on_server_group_list_finished(uint64 sch_id)
+{
+    m_plugin.onServerGroupListFinishedEvent(sch_id);
+}
+
+void PluginLoadComponent::on_client_groups_changed(uint64 sch_id, anyID client_id)
+{
+    m_plugin.onUpdateClientEvent(sch_id, client_id, 0, "", "");
+}
+
+void PluginLoadComponent::on_voice(uint64 sch_id, anyID client_id, short* samples, int frame_count, int channels)
+{
+    m_plugin.onEditPlaybackVoiceDataEvent(sch_id, client_id, samples, frame_count, channels);
+}
+
+// ServersInfoLoadComponent
+
+void ServersInfoLoadComponent::on_connect_status(uint64 sch_id, int new_status)
+{
+    m_servers_info.onConnectStatusChangeEvent(sch_id, new_status, 0);
+}
+
+void ServersInfoLoadComponent::on_server_group(uint64 sch_id, uint64 server_group_id, const char* name)
+{
+    m_servers_info.onServerGroupListEvent(sch_id, server_group_id, name, 1, 0, 0);
+}
+
+void ServersInfoLoadComponent::on_server_group_list_finished(uint64 sch_id)
+{
+    m_servers_info.onServerGroupListFinishedEvent(sch_id);
+}
+
+void ServersInfoLoadComponent::on_tick(uint64 sch_id, anyID some_client_id, uint64 some_channel_id)
+{
+    Q_UNUSED(some_client_id);
+    Q_UNUSED(some_channel_id);
+
+    m_servers_info.find_server_by_unique_id(server_unique_id(sch_id));
+    auto server_info = m_servers_info.get_server_info(sch_id);
+    if (server_info)
+        server_info->GetServerGroupId("Group 1");
+}
+
+// HelpersLoadComponent
+
+void HelpersLoadComponent::on_tick(uint64 sch_id, anyID some_client_id, uint64 some_channel_id)
+{
+    Q_UNUSED(some_client_id);
+
+    const auto kPath = TSHelpers::GetChannelPath(sch_id, some_channel_id);
+    TSHelpers::GetChannelIDFromPath(sch_id, kPath);
+
+    QVector<uint64> sub_channels;
+    TSHelpers::GetSubChannels(sch_id, some_channel_id, &sub_channels);
+
+    TSHelpers::SetWhisperList(sch_id, GROUPWHISPERTYPE_SERVERGROUP, GROUPWHISPERTARGETMODE_ALL, QString::null, 1);
+}
+
+// LoadGenerator
+
+LoadGenerator::LoadGenerator(StandInHost& host)
+    : m_host(host)
+{
+    // a second of something voice-like: a few harmonics under a slow envelope, plus noise
+    std::mt19937 random(0);
+    std::uniform_int_distribution<int> noise(-400, 400);
+    m_signal.resize(48000);
+    for (int i = 0; i < m_signal.size(); ++i)
+    {
+        const auto kT = i / 48000.0;
+        const auto kEnvelope = 0.5 + 0.5 * std::sin(2 * kPi * 3 * kT);
+        const auto kValue = kEnvelope * (6000 * std::sin(2 * kPi * 180 * kT) + 3000 * std::sin(2 * kPi * 360 * kT) + 1500 * std::sin(2 * kPi * 720 * kT));
+        m_signal[i] = static_cast<short>(qBound(-32768, static_cast<int>(kValue) + noise(random), 32767));
+    }
+}
+
+void LoadGenerator::add_component(LoadComponent* component)
+{
+    m_components.append(component);
+}
+
+template <typename F>
+void LoadGenerator::dispatch(F f)
+{
+    // cpu time for the cost, wall time for the latency; on Windows the thread times only advance with the scheduler tick,
+    // so per component cpu time is only meaningful summed over many events
+    QElapsedTimer timer;
+    for (int i = 0; i < m_components.size(); ++i)
+    {
+        const auto kCpuBefore = thread_cpu_ns();
+        timer.start();
+        f(m_components[i]);
+        const auto kElapsed = timer.nsecsElapsed();
+        const auto kCpu = thread_cpu_ns() - kCpuBefore;
+
+        auto& timing = m_timings[i];
+        ++timing.events;
+        timing.cpu_ns += kCpu;
+        timing.total_ns += kElapsed;
+        timing.max_ns = qMax(timing.max_ns, kElapsed);
+        size_t bucket = 0;
+        while (bucket < timing.histogram.size() - 1 && (kElapsed >> (bucket + 1)) > 0)
+            ++bucket;
+
+        ++timing.histogram[bucket];
+    }
+}
+
+bool LoadGenerator::chance(double p)
+{
+    return std::generate_canonical<double, 32>(m_random) < p;
+}
+
+int LoadGenerator::pick(int count)
+{
+    return std::uniform_int_distribution<int>(0, count - 1)(m_random);
+}
+
+void LoadGenerator::connect_server(const Config& config, uint64 sch_id)
+{
+    auto& server = m_host.server(sch_id);
+    server.name = QString("Bench Server %1").arg(sch_id).toUtf8();
+    server.unique_id = server_unique_id(sch_id).toUtf8();
+    server.default_channel_group = 8;
+
+    m_host.set_connection_status(sch_id, STATUS_CONNECTING);
+    dispatch([&](LoadComponent* c) { c->on_connect_status(sch_id, STATUS_CONNECTING); });
+
+    // a tree four channels wide on each level
+    for (int i = 1; i <= config.channels; ++i)
+        m_host.add_channel(sch_id, i, (i - 1) / 4, QString("Channel %1").arg(i).toUtf8());
+
+    m_host.set_connection_status(sch_id, STATUS_CONNECTED);
+    dispatch([&](LoadComponent* c) { c->on_connect_status(sch_id, STATUS_CONNECTED); });
+
+    m_host.set_my_id(sch_id, kMyId);
+    m_host.move_client(sch_id, kMyId, 1);
+    m_host.set_connection_status(sch_id, STATUS_CONNECTION_ESTABLISHING);
+    dispatch([&](LoadComponent* c) { c->on_connect_status(sch_id, STATUS_CONNECTION_ESTABLISHING); });
+
+    for (int i = 0; i < config.clients; ++i)
+    {
+        const auto kClientId = static_cast<anyID>(kMyId + 1 + i);
+        const auto kChannelId = static_cast<uint64>(1 + pick(config.channels));
+        m_host.move_client(sch_id, kClientId, kChannelId);
+        auto& client = server.clients[kClientId];
+        client.nickname = QString("Client %1").arg(kClientId).toUtf8();
+        client.unique_id = QString("client-%1=").arg(kClientId).toUtf8();
+        client.channel_group_id = 8 + pick(3);
+        client.channel_commander = chance(0.05) ? 1 : 0;
+        QByteArrayList groups;
+        const auto kGroupCount = 1 + pick(3);
+        for (int g = 0; g < kGroupCount; ++g)
+            groups << QByteArray::number(1 + pick(config.server_groups));
+
+        client.server_groups = groups.join(',');
+        dispatch([&](LoadComponent* c) { c->on_client_move(sch_id, kClientId, 0, kChannelId, ENTER_VISIBILITY); });
+    }
+
+    m_host.set_connection_status(sch_id, STATUS_CONNECTION_ESTABLISHED);
+    dispatch([&](LoadComponent* c) { c->on_connect_status(sch_id, STATUS_CONNECTION_ESTABLISHED); });
+
+    for (int g = 1; g <= config.server_groups; ++g)
+    {
+        const auto kName = QString("Group %1").arg(g).toUtf8();
+        dispatch([&](LoadComponent* c) { c->on_server_group(sch_id, g, kName.constData()); });
+    }
+    dispatch([&](LoadComponent* c) { c->on_server_group_list_finished(sch_id); });
+}
+
+void LoadGenerator::disconnect_server(uint64 sch_id)
+{
+    // like the client, we get moved to channel 0 before the disconnect
+    m_host.set_connection_status(sch_id, STATUS_DISCONNECTED);
+    dispatch([&](LoadComponent* c) { c->on_client_move(sch_id, kMyId, 1, 0, LEAVE_VISIBILITY); });
+    dispatch([&](LoadComponent* c) { c->on_connect_status(sch_id, STATUS_DISCONNECTED); });
+    m_host.remove_server(sch_id);
+}
+
+void LoadGenerator::tick(const Config& config, uint64 sch_id, int tick)
+{
+    const auto kStopRate = 1.0 / qMax(1, config.talk_burst_ticks);
+    const auto kStartRate = (config.talk_duty >= 1.0) ? 1.0 : config.talk_duty * kStopRate / (1.0 - config.talk_duty);
+    const auto kSamples = config.frame_count * config.channels_per_frame;
+    m_buffer.resize(kSamples);
+
+    auto& server = m_host.server(sch_id);
+    for (int i = 0; i < config.clients; ++i)
+    {
+        const auto kClientId = static_cast<anyID>(kMyId + 1 + i);
+        auto& client = server.clients[kClientId];
+
+        if (chance(config.move_rate))
+        {
+            const auto kOld = client.channel_id;
+            const auto kNew = static_cast<uint64>(1 + pick(config.channels));
+            m_host.move_client(sch_id, kClientId, kNew);
+            dispatch([&](LoadComponent* c) { c->on_client_move(sch_id, kClientId, kOld, kNew, RETAIN_VISIBILITY); });
+        }
+
+        if (chance(config.group_change_rate))
+        {
+            auto groups = client.server_groups.split(',');
+            const auto kGroup = QByteArray::number(1 + pick(config.server_groups));
+            if (groups.contains(kGroup) && groups.size() > 1)
+                groups.removeAll(kGroup);
+            else if (!groups.contains(kGroup))
+                groups.append(kGroup);
+
+            client.server_groups = groups.join(',');
+            dispatch([&](LoadComponent* c) { c->on_client_groups_changed(sch_id, kClientId); });
+        }
+
+        const auto kIsTalking = (client.talking == STATUS_TALKING);
+        if (chance(kIsTalking ? kStopRate : kStartRate))
+        {
+            const auto kStatus = kIsTalking ? STATUS_NOT_TALKING : STATUS_TALKING;
+            const auto kIsWhisper = kIsTalking ? client.whispering : (chance(0.05) ? 1 : 0);
+            m_host.set_talk_status(sch_id, kClientId, kStatus, kIsWhisper);
+            dispatch([&](LoadComponent* c) { c->on_talk_status(sch_id, kClientId, kStatus, kIsWhisper); });
+        }
+
+        if (client.talking == STATUS_TALKING)
+        {
+            // the signal is read as a ring, so blocks of any size fit
+            const auto kOffset = static_cast<int>((static_cast<qint64>(tick) * kSamples + kClientId * 97) % m_signal.size());
+            dispatch([&](LoadComponent* c)
+            {
+                for (int copied = 0, offset = kOffset; copied < kSamples; offset = 0)
+                {
+                    const auto kRun = qMin(kSamples - copied, m_signal.size() - offset);
+                    std::copy(m_signal.constBegin() + offset, m_signal.constBegin() + offset + kRun, m_buffer.begin() + copied);
+                    copied += kRun;
+                }
+                c->on_voice(sch_id, kClientId, m_buffer.data(), config.frame_count, config.channels_per_frame);
+            });
+        }
+    }
+
+    const auto kSomeClient = static_cast<anyID>(kMyId + 1 + pick(qMax(1, config.clients)));
+    const auto kSomeChannel = static_cast<uint64>(1 + pick(config.channels));
+    dispatch([&](LoadComponent* c) { c->on_tick(sch_id, kSomeClient, kSomeChannel); });
+}
+
+LoadGenerator::Result LoadGenerator::run(const Config& config)
+{
+    m_random.seed(config.seed);
+    m_timings.fill(Timing(), m_components.size());
+    m_host.reset();
+    m_host.install();
+
+    const auto kMemoryBefore = resident_bytes();
+    const auto kCpuBefore = thread_cpu_ns();
+
+    for (int s = 1; s <= config.servers; ++s)
+        connect_server(config, s);
+
+    m_host.set_current_server(1);
+    for (int t = 0; t < config.ticks; ++t)
+    {
+        for (int s = 1; s <= config.servers; ++s)
+            tick(config, s, t);
+
+        // Volumes and friends clean up with deleteLater
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    const auto kMemoryPeak = resident_bytes();
+    Result result;
+    result.api_calls = m_host.api_calls();
+
+    for (int s = 1; s <= config.servers; ++s)
+        disconnect_server(s);
+
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    result.servers = config.servers;
+    result.clients = config.clients;
+    result.cpu_ns = thread_cpu_ns() - kCpuBefore;
+    result.memory_peak_growth = kMemoryPeak - kMemoryBefore;
+    result.memory_growth = resident_bytes() - kMemoryBefore;
+    for (int i = 0; i < m_components.size(); ++i)
+    {
+        const auto& timing = m_timings.at(i);
+        Result::Component component;
+        component.name = m_components.at(i)->name();
+        component.events = timing.events;
+        component.cpu_ns = timing.cpu_ns;
+        component.total_ns = timing.total_ns;
+        component.max_ns = timing.max_ns;
+        component.p50_ns = percentile(timing.histogram, timing.events, 0.5);
+        component.p99_ns = percentile(timing.histogram, timing.events, 0.99);
+        result.components.append(component);
+    }
+    return result;
+}
+
+QVector<LoadGenerator::Result> LoadGenerator::sweep(Config config, const QVector<int>& servers, const QVector<int>& clients)
+{
+    QVector<Result> results;
+    for (auto n : servers)
+    {
+        for (auto m : clients)
+        {
+            config.servers = n;
+            config.clients = m;
+            results.append(run(config));
+        }
+    }
+    return results;
+}
+
+QString LoadGenerator::report(const QVector<Result>& results)
+{
+    QString result;
+    QTextStream out(&result);
+    // cpu: thread cpu time; wall and the latencies p50, p99 and max: wall time
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+           .arg("servers", 7).arg("clients", 7).arg("component", -14).arg("events", 10)
+           .arg("cpu ms", 10).arg("wall ms", 10).arg("p50 us", 9).arg("p99 us", 9).arg("max us", 9).arg("cpu ns/client", 14);
+    for (const auto& r : results)
+    {
+        const auto kPopulation = qMax<qint64>(1, static_cast<qint64>(r.servers) * r.clients);
+        for (const auto& c : r.components)
+        {
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+                   .arg(r.servers, 7).arg(r.clients, 7).arg(c.name, -14).arg(c.events, 10)
+                   .arg(c.cpu_ns / 1e6, 10, 'f', 2)
+                   .arg(c.total_ns / 1e6, 10, 'f', 2)
+                   .arg(c.p50_ns / 1e3, 9, 'f', 2)
+                   .arg(c.p99_ns / 1e3, 9, 'f', 2)
+                   .arg(c.max_ns / 1e3, 9, 'f', 2)
+                   .arg(c.cpu_ns / kPopulation, 14);
+        }
+        out << QString("%1 %2 total cpu %3 ms, %4 api calls, memory +%5 KiB peak, +%6 KiB after disconnect\n")
+               .arg(r.servers, 7).arg(r.clients, 7)
+               .arg(r.cpu_ns / 1e6, 0, 'f', 2)
+               .arg(r.api_calls)
+               .arg(r.memory_peak_growth / 1024)
+               .arg(r.memory_growth / 1024);
+    }
+    return result;
+}
+
+qint64 LoadGenerator::resident_bytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<qint64>(counters.WorkingSetSize);
+
+    return 0;
+#elif defined(Q_OS_LINUX)
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+
+    const auto kFields = statm.readAll().split(' ');
+    if (kFields.size() < 2)
+        return 0;
+
+    return kFields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+qint64 LoadGenerator::thread_cpu_ns()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    const auto kKernel = (static_cast<quint64>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const auto kUser = (static_cast<quint64>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return static_cast<qint64>((kKernel + kUser) * 100);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+qint64 LoadGenerator::percentile(const Histogram& histogram, quint64 events, double p)
+{
+    if (events == 0)
+        return 0;
+
+    const auto kTarget = static_cast<quint64>(std::ceil(events * p));
+    quint64 seen = 0;
+    for (size_t i = 0; i < histogram.size(); ++i)
+    {
+        seen += histogram[i];
+        if (seen >= kTarget)
+            return static_cast<qint64>(1) << (i + 1);   // upper bound of the bucket
+    }
+    return static_cast<qint64>(1) << histogram.size();
+}
@@ -0,0 +1,545 @@
+#include "bench/stand_in_host.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "teamspeak/public_errors.h"
+#include "teamspeak/public_errors_rare.h"
+#include "teamspeak/public_rare_definitions.h"
+#include "ts3_functions.h"
+#include "plugin.h"
+
+namespace {
+
+    char* copy_string(const QByteArray& value)
+    {
+        auto result = static_cast<char*>(malloc(value.size() + 1));
+        memcpy(result, value.constData(), value.size());
+        result[value.size()] = '\0';
+        return result;
+    }
+
+    void copy_path(const QByteArray& value, char* path, size_t max_len)
+    {
+        if (max_len == 0)
+            return;
+
+        const auto kLen = qMin(static_cast<size_t>(value.size()), max_len - 1);
+        memcpy(path, value.constData(), kLen);
+        path[kLen] = '\0';
+    }
+}
+
+StandInHost* StandInHost::instance()
+{
+    static StandInHost host;
+    return &host;
+}
+
+void StandInHost::install()
+{
+    ts3Functions.freeMemory = &StandInHost::freeMemory;
+    ts3Functions.logMessage = &StandInHost::logMessage;
+    ts3Functions.getErrorMessage = &StandInHost::getErrorMessage;
+    ts3Functions.getConnectionStatus = &StandInHost::getConnectionStatus;
+    ts3Functions.getClientID = &StandInHost::getClientID;
+    ts3Functions.getClientSelfVariableAsInt = &StandInHost::getClientSelfVariableAsInt;
+    ts3Functions.getClientVariableAsInt = &StandInHost::getClientVariableAsInt;
+    ts3Functions.getClientVariableAsString = &StandInHost::getClientVariableAsString;
+    ts3Functions.getClientList = &StandInHost::getClientList;
+    ts3Functions.getChannelOfClient = &StandInHost::getChannelOfClient;
+    ts3Functions.getChannelVariableAsString = &StandInHost::getChannelVariableAsString;
+    ts3Functions.getChannelVariableAsUInt64 = &StandInHost::getChannelVariableAsUInt64;
+    ts3Functions.getChannelIDFromChannelNames = &StandInHost::getChannelIDFromChannelNames;
+    ts3Functions.getChannelList = &StandInHost::getChannelList;
+    ts3Functions.getChannelClientList = &StandInHost::getChannelClientList;
+    ts3Functions.getParentChannelOfChannel = &StandInHost::getParentChannelOfChannel;
+    ts3Functions.getServerConnectionHandlerList = &StandInHost::getServerConnectionHandlerList;
+    ts3Functions.getServerVariableAsString = &StandInHost::getServerVariableAsString;
+    ts3Functions.getServerVariableAsUInt64 = &StandInHost::getServerVariableAsUInt64;
+    ts3Functions.isWhispering = &StandInHost::isWhispering;
+    ts3Functions.getClientDisplayName = &StandInHost::getClientDisplayName;
+    ts3Functions.requestClientSetWhisperList = &StandInHost::requestClientSetWhisperList;
+    ts3Functions.requestClientVariables = &StandInHost::requestClientVariables;
+    ts3Functions.printMessage = &StandInHost::printMessage;
+    ts3Functions.playWaveFile = &StandInHost::playWaveFile;
+    ts3Functions.getCurrentServerConnectionHandlerID = &StandInHost::getCurrentServerConnectionHandlerID;
+    ts3Functions.requestInfoUpdate = &StandInHost::requestInfoUpdate;
+    ts3Functions.getResourcesPath = &StandInHost::getResourcesPath;
+    ts3Functions.getConfigPath = &StandInHost::getConfigPath;
+}
+
+void StandInHost::reset()
+{
+    m_servers.clear();
+    m_current = 0;
+    reset_api_calls();
+}
+
+StandInHost::Server& StandInHost::server(uint64 sch_id)
+{
+    return m_servers[sch_id];
+}
+
+void StandInHost::remove_server(uint64 sch_id)
+{
+    m_servers.remove(sch_id);
+    if (m_current == sch_id)
+        m_current = m_servers.isEmpty() ? 0 : m_servers.firstKey();
+}
+
+void StandInHost::set_connection_status(uint64 sch_id, int status)
+{
+    auto& s = server(sch_id);
+    s.status = status;
+    if (status == STATUS_DISCONNECTED)
+    {
+        s.clients.clear();
+        s.my_id = 0;
+    }
+    if (m_current == 0)
+        m_current = sch_id;
+}
+
+void StandInHost::set_my_id(uint64 sch_id, anyID my_id)
+{
+    server(sch_id).my_id = my_id;
+}
+
+void StandInHost::add_channel(uint64 sch_id, uint64 channel_id, uint64 parent_id, const QByteArray& name)
+{
+    auto& channel = server(sch_id).channels[channel_id];
+    channel.parent_id = parent_id;
+    channel.name = name;
+}
+
+void StandInHost::move_client(uint64 sch_id, anyID client_id, uint64 channel_id)
+{
+    auto& s = server(sch_id);
+    if (channel_id == 0)
+    {
+        s.clients.remove(client_id);
+        return;
+    }
+    auto& client = s.clients[client_id];
+    client.channel_id = channel_id;
+    if (!s.channels.contains(channel_id))
+        s.channels[channel_id].name = QByteArray::number(channel_id);
+}
+
+void StandInHost::set_talk_status(uint64 sch_id, anyID client_id, int status, int is_whispering)
+{
+    auto client = find_client(sch_id, client_id);
+    if (!client)
+        return;
+
+    client->talking = status;
+    client->whispering = is_whispering;
+}
+
+StandInHost::Server* StandInHost::find_server(uint64 sch_id)
+{
+    auto it = m_servers.find(sch_id);
+    return (it == m_servers.end()) ? nullptr : &it.value();
+}
+
+StandInHost::Client* StandInHost::find_client(uint64 sch_id, anyID client_id)
+{
+    auto s = find_server(sch_id);
+    if (!s)
+        return nullptr;
+
+    auto it = s->clients.find(client_id);
+    return (it == s->clients.end()) ? nullptr : &it.value();
+}
+
+// ts3Functions
+
+unsigned int StandInHost::freeMemory(void* pointer)
+{
+    free(pointer);
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::logMessage(const char* log_message, LogLevel severity, const char* channel, uint64 log_id)
+{
+    auto host = instance();
+    host->count();
+    if (host->m_is_verbose)
+        printf("%llu %d %s: %s\n", static_cast<unsigned long long>(log_id), severity, channel, log_message);
+
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getErrorMessage(unsigned int error_code, char** error)
+{
+    instance()->count();
+    *error = copy_string(QByteArray("error ") + QByteArray::number(error_code));
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getConnectionStatus(uint64 sch_id, int* result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    *result = s ? s->status : STATUS_DISCONNECTED;
+    return s ? ERROR_ok : ERROR_not_connected;
+}
+
+unsigned int StandInHost::getClientID(uint64 sch_id, anyID* result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s || s->status == STATUS_DISCONNECTED)
+        return ERROR_not_connected;
+
+    *result = s->my_id;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getClientSelfVariableAsInt(uint64 sch_id, size_t flag, int* result)
+{
+    auto s = instance()->find_server(sch_id);
+    if (!s || s->status == STATUS_DISCONNECTED)
+    {
+        instance()->count();
+        return ERROR_not_connected;
+    }
+    return getClientVariableAsInt(sch_id, s->my_id, flag, result);
+}
+
+unsigned int StandInHost::getClientVariableAsInt(uint64 sch_id, anyID client_id, size_t flag, int* result)
+{
+    auto host = instance();
+    host->count();
+    auto client = host->find_client(sch_id, client_id);
+    if (!client)
+        return ERROR_client_invalid_id;
+
+    switch (flag)
+    {
+    case CLIENT_FLAG_TALKING:
+        *result = client->talking;
+        break;
+    case CLIENT_TYPE:
+        *result = client->type;
+        break;
+    case CLIENT_CHANNEL_GROUP_ID:
+        *result = client->channel_group_id;
+        break;
+    case CLIENT_IS_CHANNEL_COMMANDER:
+        *result = client->channel_commander;
+        break;
+    case CLIENT_INPUT_HARDWARE:
+        *result = (sch_id == host->m_current) ? 1 : 0;
+        break;
+    default:
+        *result = 0;
+        break;
+    }
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getClientVariableAsString(uint64 sch_id, anyID client_id, size_t flag, char** result)
+{
+    auto host = instance();
+    host->count();
+    auto client = host->find_client(sch_id, client_id);
+    if (!client)
+        return ERROR_client_invalid_id;
+
+    switch (flag)
+    {
+    case CLIENT_SERVERGROUPS:
+        *result = copy_string(client->server_groups);
+        break;
+    case CLIENT_UNIQUE_IDENTIFIER:
+        *result = copy_string(client->unique_id);
+        break;
+    case CLIENT_NICKNAME:
+        *result = copy_string(client->nickname);
+        break;
+    default:
+        *result = copy_string(QByteArray());
+        break;
+    }
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getClientList(uint64 sch_id, anyID** result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s)
+        return ERROR_not_connected;
+
+    auto list = static_cast<anyID*>(malloc(sizeof(anyID) * (s->clients.size() + 1)));
+    auto n = 0;
+    for (auto it = s->clients.cbegin(); it != s->clients.cend(); ++it)
+        list[n++] = it.key();
+
+    list[n] = 0;
+    *result = list;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getChannelOfClient(uint64 sch_id, anyID client_id, uint64* result)
+{
+    auto host = instance();
+    host->count();
+    auto client = host->find_client(sch_id, client_id);
+    if (!client)
+        return ERROR_client_invalid_id;
+
+    *result = client->channel_id;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getChannelVariableAsString(uint64 sch_id, uint64 channel_id, size_t flag, char** result)
+{
+    Q_UNUSED(flag);
+
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s || !s->channels.contains(channel_id))
+        return ERROR_channel_invalid_id;
+
+    *result = copy_string(s->channels.value(channel_id).name);
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getChannelVariableAsUInt64(uint64 sch_id, uint64 channel_id, size_t flag, uint64* result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s || !s->channels.contains(channel_id))
+        return ERROR_channel_invalid_id;
+
+    *result = (flag == CHANNEL_ORDER) ? s->channels.value(channel_id).order : 0;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getChannelIDFromChannelNames(uint64 sch_id, char** channel_name_array, uint64* result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s)
+        return ERROR_not_connected;
+
+    uint64 parent = 0;
+    for (auto name = channel_name_array; *name && **name; ++name)
+    {
+        auto found = false;
+        for (auto it = s->channels.cbegin(); it != s->channels.cend(); ++it)
+        {
+            if (it.value().parent_id == parent && it.value().name == *name)
+            {
+                parent = it.key();
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return ERROR_channel_invalid_id;
+    }
+    *result = parent;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getChannelList(uint64 sch_id, uint64** result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s)
+        return ERROR_not_connected;
+
+    auto list = static_cast<uint64*>(malloc(sizeof(uint64) * (s->channels.size() + 1)));
+    auto n = 0;
+    for (auto it = s->channels.cbegin(); it != s->channels.cend(); ++it)
+        list[n++] = it.key();
+
+    list[n] = 0;
+    *result = list;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getChannelClientList(uint64 sch_id, uint64 channel_id, anyID** result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s)
+        return ERROR_not_connected;
+
+    auto list = static_cast<anyID*>(malloc(sizeof(anyID) * (s->clients.size() + 1)));
+    auto n = 0;
+    for (auto it = s->clients.cbegin(); it != s->clients.cend(); ++it)
+    {
+        if (it.value().channel_id == channel_id)
+            list[n++] = it.key();
+    }
+    list[n] = 0;
+    *result = list;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getParentChannelOfChannel(uint64 sch_id, uint64 channel_id, uint64* result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s || !s->channels.contains(channel_id))
+        return ERROR_channel_invalid_id;
+
+    *result = s->channels.value(channel_id).parent_id;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getServerConnectionHandlerList(uint64** result)
+{
+    auto host = instance();
+    host->count();
+    auto list = static_cast<uint64*>(malloc(sizeof(uint64) * (host->m_servers.size() + 1)));
+    auto n = 0;
+    for (auto it = host->m_servers.cbegin(); it != host->m_servers.cend(); ++it)
+        list[n++] = it.key();
+
+    list[n] = 0;
+    *result = list;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getServerVariableAsString(uint64 sch_id, size_t flag, char** result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s || s->status == STATUS_DISCONNECTED)
+        return ERROR_not_connected;
+
+    if (flag == VIRTUALSERVER_NAME)
+        *result = copy_string(s->name);
+    else if (flag == VIRTUALSERVER_UNIQUE_IDENTIFIER)
+        *result = copy_string(s->unique_id);
+    else
+        *result = copy_string(QByteArray());
+
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getServerVariableAsUInt64(uint64 sch_id, size_t flag, uint64* result)
+{
+    auto host = instance();
+    host->count();
+    auto s = host->find_server(sch_id);
+    if (!s || s->status == STATUS_DISCONNECTED)
+        return ERROR_not_connected;
+
+    *result = (flag == VIRTUALSERVER_DEFAULT_CHANNEL_GROUP) ? s->default_channel_group : 0;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::isWhispering(uint64 sch_id, anyID client_id, int* result)
+{
+    auto host = instance();
+    host->count();
+    auto client = host->find_client(sch_id, client_id);
+    if (!client)
+        return ERROR_client_invalid_id;
+
+    *result = client->whispering;
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::getClientDisplayName(uint64 sch_id, anyID client_id, char* result, size_t max_len)
+{
+    auto host = instance();
+    host->count();
+    auto client = host->find_client(sch_id, client_id);
+    if (!client)
+        return ERROR_client_invalid_id;
+
+    copy_path(client->nickname, result, max_len);
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::requestClientSetWhisperList(uint64 sch_id, anyID client_id, const uint64* target_channel_ids, const anyID* target_client_ids, const char* return_code)
+{
+    Q_UNUSED(sch_id);
+    Q_UNUSED(client_id);
+    Q_UNUSED(target_channel_ids);
+    Q_UNUSED(target_client_ids);
+    Q_UNUSED(return_code);
+
+    instance()->count();
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::requestClientVariables(uint64 sch_id, anyID client_id, const char* return_code)
+{
+    Q_UNUSED(sch_id);
+    Q_UNUSED(client_id);
+    Q_UNUSED(return_code);
+
+    instance()->count();
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::printMessage(uint64 sch_id, const char* message, PluginMessageTarget message_target)
+{
+    Q_UNUSED(message_target);
+
+    auto host = instance();
+    host->count();
+    if (host->m_is_verbose)
+        printf("%llu: %s\n", static_cast<unsigned long long>(sch_id), message);
+
+    return ERROR_ok;
+}
+
+unsigned int StandInHost::playWaveFile(uint64 sch_id, const char* path)
+{
+    Q_UNUSED(sch_id);
+    Q_UNUSED(path);
+
+    instance()->count();
+    return ERROR_ok;
+}
+
+uint64 StandInHost::getCurrentServerConnectionHandlerID()
+{
+    auto host = instance();
+    host->count();
+    return host->m_current;
+}
+
+void StandInHost::requestInfoUpdate(uint64 sch_id, PluginItemType item_type, uint64 item_id)
+{
+    Q_UNUSED(sch_id);
+    Q_UNUSED(item_type);
+    Q_UNUSED(item_id);
+
+    instance()->count();
+}
+
+void StandInHost::getResourcesPath(char* path, size_t max_len)
+{
+    auto host = instance();
+    host->count();
+    copy_path(host->m_config_path, path, max_len);
+}
+
+void StandInHost::getConfigPath(char* path, size_t max_len)
+{
+    auto host = instance();
+    host->count();
+    copy_path(host->m_config_path, path, max_len);
+}
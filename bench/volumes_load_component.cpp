@@ -0,0 +1,32 @@
+#include "bench/volumes_load_component.h"
+
+#include "volume/volumes.h"
+#include "volume/dsp_volume.h"
+
+void VolumesLoadComponent::on_connect_status(uint64 sch_id, int new_status)
+{
+    m_volumes.onConnectStatusChanged(sch_id, new_status, 0);
+}
+
+void VolumesLoadComponent::on_talk_status(uint64 sch_id, anyID client_id, int status, int is_whisper)
+{
+    Q_UNUSED(is_whisper);
+
+    if (status == STATUS_TALKING)
+    {
+        if (!m_volumes.ContainsVolume(sch_id, client_id))
+        {
+            auto volume = m_volumes.AddVolume(sch_id, client_id);
+            volume->setProcessing(true);
+        }
+    }
+    else
+        m_volumes.RemoveVolume(sch_id, client_id);
+}
+
+void VolumesLoadComponent::on_voice(uint64 sch_id, anyID client_id, short* samples, int frame_count, int channels)
+{
+    auto volume = m_volumes.GetVolume(sch_id, client_id);
+    if (volume)
+        volume->process(samples, frame_count, channels);
+}
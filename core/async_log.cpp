@@ -0,0 +1,361 @@
+#include "core/async_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMetaObject>
+
+#include "teamspeak/public_errors.h"
+
+#include "ts3_functions.h"
+#include "plugin.h"
+
+#include "core/ts_logging_qt.h"
+
+static_assert((AsyncLog::kCapacity & (AsyncLog::kCapacity - 1)) == 0, "AsyncLog::kCapacity must be a power of two");
+
+AsyncLog::AsyncLog(QObject* parent)
+    : QObject(parent)
+{
+    for (int i = 0; i < kCapacity; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+AsyncLog::~AsyncLog()
+{
+    stop();
+}
+
+bool AsyncLog::start()
+{
+    if (is_running())
+        return true;
+
+    m_is_stopping.store(false, std::memory_order_relaxed);
+    m_thread = std::thread(&AsyncLog::run, this);
+    m_is_running.store(true, std::memory_order_release);
+    return true;
+}
+
+void AsyncLog::stop()
+{
+    if (!is_running())
+        return;
+
+    // late producers fall back to synchronous logging from here on;
+    // the ones already past the check never block, wait for their commit
+    m_is_running.store(false);
+    while (m_producers.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+
+    m_is_stopping.store(true, std::memory_order_release);
+    if (m_thread.joinable())
+        m_thread.join();
+
+    // the consumer is gone, this thread owns the dequeue side now
+    drain();
+
+    // a slot reserved but never committed would block the ring for the next start(); free and count it
+    for (; m_dequeue_pos != m_enqueue_pos.load(std::memory_order_relaxed); ++m_dequeue_pos)
+    {
+        m_slots[m_dequeue_pos & (kCapacity - 1)].sequence.store(m_dequeue_pos + kCapacity, std::memory_order_relaxed);
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    report_dropped();
+}
+
+bool AsyncLog::push(const QString& message, uint64 sch_id, LogLevel level)
+{
+    const ProducerScope kScope(*this);
+    if (!kScope.is_running())
+        return false;
+
+    enqueue(message, sch_id, 0, level, 0);
+    return true;
+}
+
+bool AsyncLog::push_error(const QString& message, uint64 sch_id, unsigned int error, bool is_sound_silent, quint64 suppressed)
+{
+    const ProducerScope kScope(*this);
+    if (!kScope.is_running())
+        return false;
+
+    enqueue(message, sch_id, error, LogLevel_ERROR, kFlagError | (is_sound_silent ? kFlagSoundSilent : 0),
+            static_cast<quint32>(std::min<quint64>(suppressed, UINT32_MAX)));
+    return true;
+}
+
+bool AsyncLog::push_error_literal(const char* message, uint64 sch_id, unsigned int error, bool is_sound_silent, quint64 suppressed)
+{
+    const ProducerScope kScope(*this);
+    if (!kScope.is_running())
+        return false;
+
+    quint64 pos;
+    auto slot = acquire(pos);
+    if (!slot)
+        return true;
+
+    // a format without arguments, written out as is
+    auto& record = slot->record;
+    record.sch_id = sch_id;
+    record.format = message;
+    record.error = error;
+    record.suppressed = static_cast<quint32>(std::min<quint64>(suppressed, UINT32_MAX));
+    record.level = static_cast<qint8>(LogLevel_ERROR);
+    record.flags = kFlagError | (is_sound_silent ? kFlagSoundSilent : 0);
+    record.arg_count = 0;
+    record.length = 0;
+
+    commit(slot, pos);
+    return true;
+}
+
+bool AsyncLog::push_format(const char* format, const TSLogging::LogArg* args, int count, uint64 sch_id, LogLevel level)
+{
+    const ProducerScope kScope(*this);
+    if (!kScope.is_running() || count > kMaxArgs)
+        return false;
+
+    quint64 pos;
+    auto slot = acquire(pos);
+    if (!slot)
+        return true;
+
+    auto& record = slot->record;
+    record.sch_id = sch_id;
+    record.format = format;
+    record.error = 0;
+    record.suppressed = 0;
+    record.level = static_cast<qint8>(level);
+    record.flags = 0;
+    record.arg_count = static_cast<quint8>(count);
+    int length = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        auto& arg = record.args[i];
+        arg.type = args[i].type;
+        switch (args[i].type)
+        {
+        case TSLogging::LogArg::kInt:
+            arg.i = args[i].i;
+            break;
+        case TSLogging::LogArg::kUInt:
+            arg.u = args[i].u;
+            break;
+        case TSLogging::LogArg::kDouble:
+            arg.d = args[i].d;
+            break;
+        case TSLogging::LogArg::kString:
+        {
+            const auto& string = *args[i].s;
+            const auto kLength = std::min(string.size(), kTextSize - length);
+            if (kLength < string.size())
+                record.flags |= kFlagTruncated;
+            std::memcpy(record.text + length, string.utf16(), kLength * sizeof(ushort));
+            arg.length = static_cast<quint16>(kLength);
+            length += kLength;
+            break;
+        }
+        case TSLogging::LogArg::kUtf8:
+        {
+            // stored byte-wise, the consumer decodes the UTF-8
+            const char* c = args[i].c ? args[i].c : "";
+            int byte_count = 0;
+            for (; c[byte_count] && (length + byte_count) < kTextSize; ++byte_count)
+                record.text[length + byte_count] = static_cast<uchar>(c[byte_count]);
+            if (c[byte_count])
+                record.flags |= kFlagTruncated;
+            arg.length = static_cast<quint16>(byte_count);
+            length += byte_count;
+            break;
+        }
+        }
+    }
+    record.length = static_cast<quint16>(length);
+
+    commit(slot, pos);
+    return true;
+}
+
+AsyncLog::Slot* AsyncLog::acquire(quint64& pos)
+{
+    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        auto slot = &m_slots[pos & (kCapacity - 1)];
+        const auto kSequence = slot->sequence.load(std::memory_order_acquire);
+        const auto kDiff = static_cast<qint64>(kSequence - pos);
+        if (kDiff == 0)
+        {
+            if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return slot;
+        }
+        else if (kDiff < 0)
+        {
+            // full; the consumer hasn't freed this slot yet
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+            pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    }
+}
+
+void AsyncLog::commit(Slot* slot, quint64 pos)
+{
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+bool AsyncLog::enqueue(const QString& message, uint64 sch_id, quint32 error, LogLevel level, quint8 flags, quint32 suppressed)
+{
+    quint64 pos;
+    auto slot = acquire(pos);
+    if (!slot)
+        return false;
+
+    auto& record = slot->record;
+    record.sch_id = sch_id;
+    record.format = nullptr;
+    record.error = error;
+    record.suppressed = suppressed;
+    record.level = static_cast<qint8>(level);
+    record.flags = flags;
+    record.arg_count = 0;
+    const auto kLength = std::min(message.size(), static_cast<int>(kTextSize));
+    if (kLength < message.size())
+        record.flags |= kFlagTruncated;
+    record.length = static_cast<quint16>(kLength);
+    std::memcpy(record.text, message.utf16(), kLength * sizeof(ushort));
+
+    commit(slot, pos);
+    return true;
+}
+
+bool AsyncLog::dequeue(Record& record)
+{
+    auto& slot = m_slots[m_dequeue_pos & (kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != m_dequeue_pos + 1)
+        return false;
+
+    record = slot.record;
+    slot.sequence.store(m_dequeue_pos + kCapacity, std::memory_order_release);
+    ++m_dequeue_pos;
+    return true;
+}
+
+void AsyncLog::run()
+{
+    for (;;)
+    {
+        // read the flag before draining so nothing pushed before stop() is left behind
+        const auto kIsStopping = m_is_stopping.load(std::memory_order_acquire);
+        if (drain() == 0)
+        {
+            if (kIsStopping)
+                break;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(kIdleSleepMs)));
+        }
+    }
+    report_dropped();
+}
+
+int AsyncLog::drain()
+{
+    Record record;
+    int count = 0;
+    while (dequeue(record))
+    {
+        report_dropped();
+        write(record);
+        ++count;
+    }
+    return count;
+}
+
+void AsyncLog::write(const Record& record)
+{
+    auto message = record.format ? format(record) : QString::fromUtf16(record.text, record.length);
+    if (record.flags & kFlagTruncated)
+        message.append("...");
+    if (record.suppressed > 0)
+        message.append(QString(" (%1 similar suppressed)").arg(record.suppressed));
+
+    if (record.flags & kFlagError)
+    {
+        if (record.error != ERROR_ok)
+        {
+            char* errorMsg;
+            if (ts3Functions.getErrorMessage(record.error, &errorMsg) == ERROR_ok)
+            {
+                message.append(": ").append(errorMsg);
+                ts3Functions.freeMemory(errorMsg);
+            }
+        }
+        ts3Functions.logMessage(message.toLocal8Bit().constData(), LogLevel_ERROR, ts3plugin_name(), record.sch_id);
+
+        QMetaObject::invokeMethod(this, "on_error", Qt::QueuedConnection,
+                                  Q_ARG(quint64, record.sch_id),
+                                  Q_ARG(QString, message),
+                                  Q_ARG(bool, (record.flags & kFlagSoundSilent) != 0));
+        return;
+    }
+
+    ts3Functions.logMessage(message.toLocal8Bit().constData(), static_cast<LogLevel>(record.level), ts3plugin_name(), record.sch_id);
+}
+
+QString AsyncLog::format(const Record& record)
+{
+    QString args[kMaxArgs];
+    int offset = 0;
+    for (int i = 0; i < record.arg_count; ++i)
+    {
+        const auto& arg = record.args[i];
+        switch (arg.type)
+        {
+        case TSLogging::LogArg::kInt:
+            args[i] = QString::number(arg.i);
+            break;
+        case TSLogging::LogArg::kUInt:
+            args[i] = QString::number(arg.u);
+            break;
+        case TSLogging::LogArg::kDouble:
+            args[i] = QString::number(arg.d);
+            break;
+        case TSLogging::LogArg::kString:
+            args[i] = QString::fromUtf16(record.text + offset, arg.length);
+            offset += arg.length;
+            break;
+        case TSLogging::LogArg::kUtf8:
+        {
+            QByteArray utf8(arg.length, Qt::Uninitialized);
+            for (int j = 0; j < arg.length; ++j)
+                utf8[j] = static_cast<char>(record.text[offset + j]);
+            args[i] = QString::fromUtf8(utf8);
+            offset += arg.length;
+            break;
+        }
+        }
+    }
+    return TSLogging::Format(record.format, args, record.arg_count);
+}
+
+void AsyncLog::report_dropped()
+{
+    const auto kDropped = m_dropped.load(std::memory_order_relaxed);
+    if (kDropped == m_dropped_reported)
+        return;
+
+    const auto kMessage = QString("%1 log messages dropped, the log queue was full").arg(kDropped - m_dropped_reported);
+    ts3Functions.logMessage(kMessage.toLocal8Bit().constData(), LogLevel_WARNING, ts3plugin_name(), 0);
+    m_dropped_reported = kDropped;
+}
+
+void AsyncLog::on_error(quint64 sch_id, const QString& message, bool is_sound_silent)
+{
+    TSLogging::PrintError(message, sch_id, is_sound_silent);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include "teamspeak/public_definitions.h"
+
+#include "core/ts_logging_qt.h"
+
+// Backend of TSLogging's async mode.
+// Producers copy the message, or the format and raw arguments of TSLogging::LogFormat, into a fixed size record
+// of a bounded lock-free MPSC ring and return; a background thread formats the records and forwards them to the client log.
+// Producers never block and never allocate: if the ring is full, the record is dropped and counted,
+// and the consumer reports the number of dropped records with the next record it writes.
+// The chat print and the error sound of TSLogging::Error are posted back to the thread the AsyncLog lives in.
+// stop() waits for the producers that saw it running to commit, then writes out everything committed;
+// nothing pushed while running is lost without being counted as dropped.
+class AsyncLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int kCapacity = 512;       // records, power of two
+    static const int kTextSize = 240;       // UTF-16 code units per record, shared by string arguments; longer messages are truncated
+    static const int kMaxArgs = 8;
+    static const int kIdleSleepMs = 10;
+
+    explicit AsyncLog(QObject* parent = nullptr);
+    ~AsyncLog();
+
+    // Not thread-safe, call from the thread the AsyncLog lives in
+    bool start();
+    void stop();    // writes out what's queued and joins the background thread
+
+    bool is_running() const { return m_is_running.load(std::memory_order_acquire); }
+    quint64 dropped_count() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Safe to call from any thread. Returns false if not running; the caller should log synchronously then.
+    // A dropped record still returns true.
+    bool push(const QString& message, uint64 sch_id, LogLevel level);
+    // suppressed: repeats ErrorLimiter held back since the last report of this error
+    bool push_error(const QString& message, uint64 sch_id, unsigned int error, bool is_sound_silent, quint64 suppressed = 0);
+    // message must be a string literal, like the format of push_format
+    bool push_error_literal(const char* message, uint64 sch_id, unsigned int error, bool is_sound_silent, quint64 suppressed = 0);
+    // format must outlive the record, i.e. be a string literal. Returns false if not running or for more than kMaxArgs.
+    bool push_format(const char* format, const TSLogging::LogArg* args, int count, uint64 sch_id, LogLevel level);
+
+private slots:
+    void on_error(quint64 sch_id, const QString& message, bool is_sound_silent);
+
+private:
+    struct Arg
+    {
+        TSLogging::LogArg::Type type;
+        union
+        {
+            qint64 i;
+            quint64 u;
+            double d;
+            quint16 length;     // strings are stored in text
+        };
+    };
+
+    struct Record
+    {
+        uint64 sch_id;
+        const char* format;     // nullptr: text is the message
+        quint32 error;
+        quint32 suppressed;
+        qint8 level;
+        quint8 flags;
+        quint8 arg_count;
+        quint16 length;
+        Arg args[kMaxArgs];
+        ushort text[kTextSize];
+    };
+
+    enum Flag : quint8
+    {
+        kFlagError = 1,
+        kFlagSoundSilent = 2,
+        kFlagTruncated = 4
+    };
+
+    // Vyukov's bounded queue: a slot is free for position p when its sequence is p,
+    // and holds the record of position p when its sequence is p + 1
+    struct alignas(64) Slot
+    {
+        std::atomic<quint64> sequence;
+        Record record;
+    };
+
+    Slot m_slots[kCapacity];
+    alignas(64) std::atomic<quint64> m_enqueue_pos{0};
+    alignas(64) quint64 m_dequeue_pos = 0;  // consumer only
+    std::atomic<quint64> m_dropped{0};
+    quint64 m_dropped_reported = 0;         // consumer only
+
+    std::atomic<bool> m_is_running{false};
+    std::atomic<int> m_producers{0};        // inside a push
+    std::atomic<bool> m_is_stopping{false};
+    std::thread m_thread;
+
+    // Registers a push for its duration; is_running() pairs with stop() (both seq_cst)
+    class ProducerScope
+    {
+    public:
+        explicit ProducerScope(AsyncLog& log) : m_log(log) { m_log.m_producers.fetch_add(1); }
+        ~ProducerScope() { m_log.m_producers.fetch_sub(1, std::memory_order_release); }
+        bool is_running() const { return m_log.m_is_running.load(); }
+    private:
+        AsyncLog& m_log;
+    };
+
+    Slot* acquire(quint64& pos);   // nullptr if full
+    void commit(Slot* slot, quint64 pos);
+    bool enqueue(const QString& message, uint64 sch_id, quint32 error, LogLevel level, quint8 flags, quint32 suppressed = 0);
+    bool dequeue(Record& record);
+    void run();
+    int drain();
+    void write(const Record& record);
+    static QString format(const Record& record);
+    void report_dropped();
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+
+#include <QtCore/QtGlobal>
+#include <QtCore/QVector>
+#include <QtCore/qalgorithms.h>
+
+#include "teamspeak/public_definitions.h"
+
+// A set of client ids of one server connection as a 65536 bit bitset (8 KiB).
+// Insert, remove and contains are O(1) and allocation free; iteration skips empty 64 bit words
+// using a second level summary bitset.
+class ClientIdSet
+{
+
+public:
+    bool insert(anyID client_id)
+    {
+        auto& word = m_words[client_id >> 6];
+        const auto kBit = quint64(1) << (client_id & 63);
+        if (word & kBit)
+            return false;
+
+        word |= kBit;
+        m_summary[client_id >> 12] |= quint64(1) << ((client_id >> 6) & 63);
+        ++m_count;
+        return true;
+    }
+
+    bool remove(anyID client_id)
+    {
+        auto& word = m_words[client_id >> 6];
+        const auto kBit = quint64(1) << (client_id & 63);
+        if (!(word & kBit))
+            return false;
+
+        word &= ~kBit;
+        if (!word)
+            m_summary[client_id >> 12] &= ~(quint64(1) << ((client_id >> 6) & 63));
+
+        --m_count;
+        return true;
+    }
+
+    bool contains(anyID client_id) const
+    {
+        return (m_words[client_id >> 6] >> (client_id & 63)) & 1;
+    }
+
+    int count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+
+    void clear()
+    {
+        if (m_count == 0)
+            return;
+
+        m_words.fill(0);
+        m_summary.fill(0);
+        m_count = 0;
+    }
+
+    // Calls f(anyID) for every member in ascending order; f must not modify the set
+    template <typename F>
+    void for_each(F f) const
+    {
+        if (m_count == 0)
+            return;
+
+        for (size_t s = 0; s < m_summary.size(); ++s)
+        {
+            auto summary = m_summary[s];
+            while (summary)
+            {
+                const auto kWordIndex = s * 64 + qCountTrailingZeroBits(summary);
+                auto word = m_words[kWordIndex];
+                while (word)
+                {
+                    f(static_cast<anyID>(kWordIndex * 64 + qCountTrailingZeroBits(word)));
+                    word &= word - 1;
+                }
+                summary &= summary - 1;
+            }
+        }
+    }
+
+    QVector<anyID> values() const
+    {
+        QVector<anyID> result;
+        result.reserve(m_count);
+        for_each([&result](anyID client_id) { result.append(client_id); });
+        return result;
+    }
+
+private:
+    std::array<quint64, 1024> m_words{};
+    std::array<quint64, 16> m_summary{};
+    int m_count = 0;
+};
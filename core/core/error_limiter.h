@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <QtCore/QtGlobal>
+#include <QtCore/QVector>
+
+// Token bucket per (call site, error code) for TSLogging::Error.
+// A key may report kBurst errors at once, then one per kRefillMs. Suppressed repeats are counted,
+// and the next report of the key carries the number suppressed since the last one; take_pending
+// collects them for keys that stopped reporting, TSLogging::FlushSuppressedErrors logs them on a timer.
+// The keys live in a fixed open addressing table: admit is lock-free and doesn't allocate,
+// so Error stays non-blocking for async log producers. Every occurrence is counted and can be queried
+// without parsing the log.
+class ErrorLimiter
+{
+
+public:
+    // Identifies the code that reports an error: a string literal, i.e. a message that is never built at runtime,
+    // or __FILE__ and __LINE__ (see TS_CALL_SITE). A null site isn't rate limited.
+    struct CallSite
+    {
+        const char* site;
+        int line;
+    };
+
+    struct Counter
+    {
+        CallSite call_site;
+        unsigned int error;
+        quint64 count;          // occurrences, reported or not
+        quint64 suppressed;     // of count
+        qint64 first_ms;        // on now_ms
+        qint64 last_ms;
+    };
+
+    struct Pending
+    {
+        CallSite call_site;
+        unsigned int error;
+        quint64 suppressed;
+    };
+
+    static const int kBurst = 3;
+    static const int kRefillMs = 10000;
+    static const int kMaxKeys = 256;    // power of two; beyond, new keys are reported unlimited and counted as untracked
+
+    // Returns false if this occurrence is to be suppressed;
+    // otherwise suppressed_since is the number of occurrences suppressed since the key was reported last.
+    bool admit(const CallSite& call_site, unsigned int error, quint64* suppressed_since);
+
+    // Occurrences suppressed since the last report, for summaries of keys that went quiet. Resets them.
+    QVector<Pending> take_pending();
+
+    QVector<Counter> counters() const;  // most frequent first
+    quint64 untracked_count() const { return m_untracked.load(std::memory_order_relaxed); }
+    static qint64 now_ms();
+
+private:
+    // A slot is claimed once by a CAS on key and never released; call_site and error are published by is_ready
+    struct Entry
+    {
+        std::atomic<quint64> key{0};    // 0: free
+        std::atomic<bool> is_ready{false};
+        CallSite call_site{nullptr, 0};
+        unsigned int error = 0;
+
+        std::atomic<qint64> tat_ms{0};  // GCRA's theoretical arrival time: the bucket is full again at tat_ms
+        std::atomic<quint64> count{0};
+        std::atomic<quint64> suppressed{0};
+        std::atomic<quint64> pending{0};    // suppressed since the last report
+        std::atomic<qint64> first_ms{0};
+        std::atomic<qint64> last_ms{0};
+    };
+
+    std::array<Entry, kMaxKeys> m_entries;
+    std::atomic<quint64> m_untracked{0};
+
+    static quint64 hash(const CallSite& call_site, unsigned int error);
+    Entry* find_or_claim(const CallSite& call_site, unsigned int error, qint64 now);    // nullptr if the table is full
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QtCore/QObject>
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+
+#include "teamspeak/public_definitions.h"
+
+// Binary trace of the events passing through Plugin_Base.
+// File layout: header (magic, version, voice mode), followed by records of
+// [quint8 type][quint64 nsecs since start][quint64 sch_id][payload], all written via QDataStream.
+namespace EventTrace
+{
+    const quint32 kMagic = 0x54535452; // "TSTR"
+    const quint16 kVersion = 1;
+
+    enum class Type : quint8
+    {
+        ConnectStatus = 0,      // qint32 new_status, quint32 error_number
+        Identity,               // quint16 my_id, quint64 channel_id
+        ClientMove,             // quint16 client_id, quint64 old_channel_id, quint64 new_channel_id, qint32 visibility
+        ClientMoveTimeout,      // as ClientMove
+        ClientMoveMoved,        // as ClientMove, quint16 mover_id
+        TalkStatus,             // qint32 status, qint32 is_received_whisper, quint16 client_id
+        ServerGroupList,        // quint64 group_id, QByteArray name, qint32 type
+        ServerGroupListFinished,
+        ChannelGroupList,       // quint64 group_id, QByteArray name, qint32 type
+        ChannelGroupListFinished,
+        PlaybackPreProcess,     // quint16 client_id, qint32 frame_count, qint32 channels[, samples]
+        PlaybackPostProcess,    // as PlaybackPreProcess
+        Count
+    };
+
+    // Voice buffers are by far the most frequent events; they're optional and the samples even more so
+    enum class Voice : quint8
+    {
+        None = 0,
+        Headers,    // frame count and channels only; replay feeds silence
+        Samples     // the actual pcm data, raw in native byte order
+    };
+
+    const char* type_name(Type type);
+}
+
+class EventRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EventRecorder(QObject* parent = nullptr);
+    ~EventRecorder();
+
+    bool start(const QString& file_path, EventTrace::Voice voice = EventTrace::Voice::None);
+    void stop();
+    bool is_recording() const { return m_is_recording.load(std::memory_order_relaxed); }
+    EventTrace::Voice voice() const { return m_voice.load(std::memory_order_relaxed); }
+    quint64 voice_dropped_count() const { return m_voice_dropped.load(std::memory_order_relaxed); }
+
+    void record_connect_status(uint64 sch_id, int new_status, unsigned int error_number);
+    void record_identity(uint64 sch_id, anyID my_id, uint64 channel_id);
+    void record_client_move(EventTrace::Type type, uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID mover_id = 0);
+    void record_talk_status(uint64 sch_id, int status, int is_received_whisper, anyID client_id);
+    void record_group_list(EventTrace::Type type, uint64 sch_id, uint64 group_id, const char* name, int group_type);
+    void record_group_list_finished(EventTrace::Type type, uint64 sch_id);
+    // Audio thread; never blocks. If the voice queue is full, the record is dropped and counted.
+    void record_voice(EventTrace::Type type, uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels);
+
+    static const int kVoiceCapacity = 256;      // records, power of two
+    static const int kVoiceMaxSamples = 7680;   // per record, 20 ms at 48 kHz in 8 channels; larger buffers are dropped in Samples mode
+    static const int kVoiceDrainMs = 20;
+
+private:
+    // Voice events are recorded from the audio thread, everything else from the main thread.
+    // Voice records are queued in a bounded lock-free MPSC ring (Vyukov's queue, as AsyncLog) and written by
+    // whoever holds m_mutex: a writer thread, or the main thread before its own record so the trace keeps the order.
+    struct VoiceRecord
+    {
+        quint64 nsecs;
+        uint64 sch_id;
+        EventTrace::Type type;
+        anyID client_id;
+        qint32 frame_count;
+        qint32 channels;
+    };
+
+    struct alignas(64) VoiceSlot
+    {
+        std::atomic<quint64> sequence;
+        VoiceRecord record;
+    };
+
+    QMutex m_mutex;
+    QFile m_file;
+    QDataStream m_stream;
+    QElapsedTimer m_timer;
+    std::atomic<bool> m_is_recording{false};
+    std::atomic<EventTrace::Voice> m_voice{EventTrace::Voice::None};
+
+    std::array<VoiceSlot, kVoiceCapacity> m_voice_slots;
+    std::vector<short> m_voice_samples;                 // kVoiceMaxSamples per slot; allocated by start in Samples mode
+    alignas(64) std::atomic<quint64> m_voice_enqueue_pos{0};
+    alignas(64) quint64 m_voice_dequeue_pos = 0;        // under m_mutex
+    std::atomic<quint64> m_voice_dropped{0};
+    std::atomic<int> m_voice_writers{0};                // producers that may still see the recording on
+    std::atomic<bool> m_is_voice_stopping{false};
+    std::thread m_voice_thread;
+
+    void write_head(EventTrace::Type type, uint64 sch_id);
+    void write_head(EventTrace::Type type, quint64 nsecs, uint64 sch_id);
+    void push_voice(EventTrace::Voice voice, EventTrace::Type type, uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels);
+    void drain_voice();     // under m_mutex
+    void run_voice();
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include "teamspeak/public_definitions.h"
+
+// Peak, rms and clip count of the audio block handled by the current voice callback,
+// computed on first request and shared by every later consumer within that callback.
+// Plugin_Base opens a Scope around the playback callbacks; outside of one, or for another
+// buffer, get() just analyzes. Whoever modifies the buffer in place calls invalidate().
+// Per thread, no locks, no allocation.
+class FrameAnalysis
+{
+
+public:
+    struct Result
+    {
+        short peak = 0;
+        float rms = 0.0f;       // linear, 0..1
+        int clip_count = 0;     // samples at full scale
+    };
+
+    class Scope
+    {
+    public:
+        Scope(uint64 sch_id, anyID client_id, const short* samples, int sample_count);
+        ~Scope();
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        friend class FrameAnalysis;
+        Scope* m_previous;
+        uint64 m_sch_id;
+        anyID m_client_id;
+        const short* m_samples;
+        int m_sample_count;
+        bool m_is_valid = false;
+        Result m_result;
+    };
+
+    // sample_count: frames * channels
+    static Result get(const short* samples, int sample_count);
+    static void invalidate(const short* samples);
+
+    // The server and client of the innermost scope; false outside of callbacks
+    static bool current(uint64* sch_id, anyID* client_id);
+
+    static Result analyze(const short* samples, int sample_count);
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+#include "teamspeak/public_definitions.h"
+
+// Server and channel group lists of a virtual server, kept in the plugin's config folder
+// so they're available right at connect, before the live lists have been received.
+// One file per server unique id: header (magic, version), then for server groups and channel groups
+// [quint32 count]{[quint64 group_id][QByteArray utf8 name]}, all written via QDataStream.
+namespace GroupCache
+{
+    const quint32 kMagic = 0x54534743; // "TSGC"
+    const quint16 kVersion = 1;
+
+    bool Load(const QString& server_unique_id, QMap<uint64, QString>* server_groups, QMap<uint64, QString>* channel_groups);
+    bool Save(const QString& server_unique_id, const QMap<uint64, QString>& server_groups, const QMap<uint64, QString>& channel_groups);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+
+#include <QtCore/QSet>
+#include <QtCore/QVarLengthArray>
+
+#include "teamspeak/public_definitions.h"
+
+// A set of server or channel group ids as an ascending array; up to kInlineCount ids
+// (which covers nearly all clients) are stored inline without a heap allocation.
+// Lookups are binary searches, intersections a merge of both arrays.
+class GroupSet
+{
+
+public:
+    static const int kInlineCount = 6;
+
+    using const_iterator = const uint64*;
+
+    bool insert(uint64 group_id)
+    {
+        auto pos = std::lower_bound(m_ids.constBegin(), m_ids.constEnd(), group_id);
+        if (pos != m_ids.constEnd() && *pos == group_id)
+            return false;
+
+        m_ids.insert(pos, group_id);
+        return true;
+    }
+
+    bool remove(uint64 group_id)
+    {
+        auto pos = std::lower_bound(m_ids.constBegin(), m_ids.constEnd(), group_id);
+        if (pos == m_ids.constEnd() || *pos != group_id)
+            return false;
+
+        m_ids.remove(static_cast<int>(pos - m_ids.constBegin()));
+        return true;
+    }
+
+    bool contains(uint64 group_id) const
+    {
+        return std::binary_search(m_ids.constBegin(), m_ids.constEnd(), group_id);
+    }
+
+    bool intersects(const GroupSet& other) const
+    {
+        auto a = begin();
+        auto b = other.begin();
+        while (a != end() && b != other.end())
+        {
+            if (*a < *b)
+                ++a;
+            else if (*b < *a)
+                ++b;
+            else
+                return true;
+        }
+        return false;
+    }
+
+    GroupSet intersected(const GroupSet& other) const
+    {
+        GroupSet result;
+        std::set_intersection(begin(), end(), other.begin(), other.end(), std::back_inserter(result.m_ids));
+        return result;
+    }
+
+    int count() const { return m_ids.size(); }
+    bool isEmpty() const { return m_ids.isEmpty(); }
+    void clear() { m_ids.clear(); }
+
+    const_iterator begin() const { return m_ids.constData(); }
+    const_iterator end() const { return m_ids.constData() + m_ids.size(); }
+
+    bool operator==(const GroupSet& other) const { return (count() == other.count()) && std::equal(begin(), end(), other.begin()); }
+    bool operator!=(const GroupSet& other) const { return !(*this == other); }
+
+    QSet<uint64> toSet() const
+    {
+        QSet<uint64> result;
+        result.reserve(count());
+        for (auto group_id : *this)
+            result.insert(group_id);
+
+        return result;
+    }
+
+    // Parses a comma separated id list like CLIENT_SERVERGROUPS ("6,8,9")
+    static bool FromString(const char* value, GroupSet* result)
+    {
+        result->clear();
+        uint64 id = 0;
+        bool has_digits = false;
+        for (auto c = value; ; ++c)
+        {
+            if (*c >= '0' && *c <= '9')
+            {
+                id = id * 10 + static_cast<uint64>(*c - '0');
+                has_digits = true;
+            }
+            else if (*c == ',' || *c == '\0')
+            {
+                if (has_digits)
+                    result->insert(id);
+
+                id = 0;
+                has_digits = false;
+                if (*c == '\0')
+                    return true;
+            }
+            else if (*c != ' ')
+                return false;
+        }
+    }
+
+private:
+    QVarLengthArray<uint64, kInlineCount> m_ids;
+};
@@ -2,6 +2,7 @@
 
 #include <QtCore/QObject>
 #include "teamspeak/public_definitions.h"
+#include "core/error_limiter.h"
 
 class Module : public QObject
 {
@@ -38,9 +39,17 @@ protected:
     void Log(QString message, uint64 serverConnectionHandlerID, LogLevel logLevel);
     inline void Log(QString message, LogLevel logLevel)     {Log(message, 0, logLevel);}
     inline void Log(QString message)                        {Log(message, 0, LogLevel_INFO);}
+    void Error(const ErrorLimiter::CallSite& callSite, QString message, uint64 serverConnectionHandlerID, unsigned int error);
     void Error(QString message, uint64 serverConnectionHandlerID, unsigned int error);
     inline void Error(QString message, unsigned int error)  {Error(message, 0, error);}
     inline void Error(QString message)                      {Error(message, 0, NULL);}
+    // A literal message is rate limited as its own call site, see TSLogging::Error
+    template <size_t N>
+    void Error(const char (&message)[N], uint64 serverConnectionHandlerID, unsigned int error)   {Error(ErrorLimiter::CallSite{message, 0}, message, serverConnectionHandlerID, error);}
+    template <size_t N>
+    void Error(const char (&message)[N], unsigned int error)    {Error(ErrorLimiter::CallSite{message, 0}, message, 0, error);}
+    template <size_t N>
+    void Error(const char (&message)[N])                        {Error(ErrorLimiter::CallSite{message, 0}, message, 0, NULL);}
     bool m_isPrintEnabled;
 
 private:
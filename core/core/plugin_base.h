@@ -1,11 +1,13 @@
 #pragma once
 
 #include <QtCore/QObject>
+#include <QtCore/QTimer>
 
 #include "core/translator.h"
 #include "core/ts_context_menu_qt.h"
 #include "core/ts_infodata_qt.h"
 #include "core/talkers.h"
+#include "core/event_recorder.h"
 
 class Plugin_Base : public QObject
 {
@@ -20,6 +22,7 @@ public:
 	TSContextMenu& context_menu();
 	TSInfoData& info_data();
 	Talkers& talkers();
+	EventRecorder& event_recorder();
 
 	// Plugin funcs
 
@@ -52,26 +55,36 @@ public:
 	/* Clientlib */
 	void onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus, unsigned int errorNumber);
 	virtual void on_connect_status_changed(uint64 sch_id, int new_status, unsigned int error_number) {};
-	/*void onNewChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 channelParentID);
+	//void onNewChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 channelParentID);
 	void onNewChannelCreatedEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 channelParentID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier);
+	virtual void on_new_channel_created(uint64 sch_id, uint64 channel_id, uint64 channel_parent_id, anyID invoker_id, const char* invoker_name, const char* invoker_uid) {};
 	void onDelChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier);
+	virtual void on_del_channel(uint64 sch_id, uint64 channel_id, anyID invoker_id, const char* invoker_name, const char* invoker_uid) {};
 	void onChannelMoveEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 newChannelParentID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier);
+	virtual void on_channel_move(uint64 sch_id, uint64 channel_id, uint64 new_channel_parent_id, anyID invoker_id, const char* invoker_name, const char* invoker_uid) {};
 	void onUpdateChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID);
+	virtual void on_update_channel(uint64 sch_id, uint64 channel_id) {};
 	void onUpdateChannelEditedEvent(uint64 serverConnectionHandlerID, uint64 channelID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier);
-	void onUpdateClientEvent(uint64 serverConnectionHandlerID, anyID clientID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier);*/
+	virtual void on_update_channel_edited(uint64 sch_id, uint64 channel_id, anyID invoker_id, const char* invoker_name, const char* invoker_uid) {};
+	void onUpdateClientEvent(uint64 serverConnectionHandlerID, anyID clientID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier);
+	virtual void on_update_client(uint64 sch_id, anyID client_id, anyID invoker_id, const char* invoker_name, const char* invoker_uid) {};
 	void onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, const char* moveMessage);
 	virtual void on_client_move(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID my_id, const char* move_message) {};
-	//void onClientMoveSubscriptionEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility);
+	void onClientMoveSubscriptionEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility);
+	virtual void on_client_move_subscription(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility) {};
 	void onClientMoveTimeoutEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, const char* timeoutMessage);
 	virtual void on_client_move_timeout(uint64 sch_id, anyID client_id, uint64 old_channel_id, anyID my_id, const char* timeout_message) {};
 	void onClientMoveMovedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID moverID, const char* moverName, const char* moverUniqueIdentifier, const char* moveMessage);
 	virtual void on_client_move_moved(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID my_id, anyID mover_id, const char* mover_name, const char* mover_unique_id, const char* move_message) {};
-	/*void onClientKickFromChannelEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage);
+	void onClientKickFromChannelEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage);
+	virtual void on_client_kick_from_channel(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID kicker_id, const char* kicker_name, const char* kicker_unique_id, const char* kick_message) {};
 	void onClientKickFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage);
-	void onClientIDsEvent(uint64 serverConnectionHandlerID, const char* uniqueClientIdentifier, anyID clientID, const char* clientName);
+	virtual void on_client_kick_from_server(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID kicker_id, const char* kicker_name, const char* kicker_unique_id, const char* kick_message) {};
+	/*void onClientIDsEvent(uint64 serverConnectionHandlerID, const char* uniqueClientIdentifier, anyID clientID, const char* clientName);
 	void onClientIDsFinishedEvent(uint64 serverConnectionHandlerID);
-	void onServerEditedEvent(uint64 serverConnectionHandlerID, anyID editerID, const char* editerName, const char* editerUniqueIdentifier);
-	void onServerUpdatedEvent(uint64 serverConnectionHandlerID);*/
+	void onServerEditedEvent(uint64 serverConnectionHandlerID, anyID editerID, const char* editerName, const char* editerUniqueIdentifier);*/
+	void onServerUpdatedEvent(uint64 serverConnectionHandlerID);
+	virtual void on_server_updated(uint64 sch_id) {};
 	virtual int on_server_error(uint64 sch_id, const char* error_message, unsigned int error, const char* return_code, const char* extra_message) { return 0; };
 	/*void onServerStopEvent(uint64 serverConnectionHandlerID, const char* shutdownMessage);
 	int  onTextMessageEvent(uint64 serverConnectionHandlerID, anyID targetMode, anyID toID, anyID fromID, const char* fromName, const char* fromUniqueIdentifier, const char* message, int ffIgnored);*/
@@ -98,19 +111,24 @@ public:
 	void onUserLoggingMessageEvent(const char* logMessage, int logLevel, const char* logChannel, uint64 logID, const char* logTime, const char* completeLogString);*/
 
 	/* Clientlib rare */
-	/*void onClientBanFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, uint64 time, const char* kickMessage);
-	int  onClientPokeEvent(uint64 serverConnectionHandlerID, anyID fromClientID, const char* pokerName, const char* pokerUniqueIdentity, const char* message, int ffIgnored);*/
+	void onClientBanFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, uint64 time, const char* kickMessage);
+	virtual void on_client_ban_from_server(uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID kicker_id, const char* kicker_name, const char* kicker_unique_id, uint64 time, const char* kick_message) {};
+	/*int  onClientPokeEvent(uint64 serverConnectionHandlerID, anyID fromClientID, const char* pokerName, const char* pokerUniqueIdentity, const char* message, int ffIgnored);*/
 	virtual void on_client_self_variable_update(uint64 sch_id, int flag, const char* old_value, const char* new_value) {};
 	/*void onFileListEvent(uint64 serverConnectionHandlerID, uint64 channelID, const char* path, const char* name, uint64 size, uint64 datetime, int type, uint64 incompletesize, const char* returnCode);
 	void onFileListFinishedEvent(uint64 serverConnectionHandlerID, uint64 channelID, const char* path);
 	void onFileInfoEvent(uint64 serverConnectionHandlerID, uint64 channelID, const char* name, uint64 size, uint64 datetime);*/
+	void onServerGroupListEvent(uint64 serverConnectionHandlerID, uint64 serverGroupID, const char* name, int type, int iconID, int saveDB);
 	virtual void on_server_group_list(uint64 sch_id, uint64 server_group_id, const char* name, int type, int icon_id, int save_db) {};
+	void onServerGroupListFinishedEvent(uint64 serverConnectionHandlerID);
 	virtual void on_server_group_list_finished(uint64 sch_id) {};
 	/*void onServerGroupByClientIDEvent(uint64 serverConnectionHandlerID, const char* name, uint64 serverGroupList, uint64 clientDatabaseID);
 	void onServerGroupPermListEvent(uint64 serverConnectionHandlerID, uint64 serverGroupID, unsigned int permissionID, int permissionValue, int permissionNegated, int permissionSkip);
 	void onServerGroupPermListFinishedEvent(uint64 serverConnectionHandlerID, uint64 serverGroupID);
 	void onServerGroupClientListEvent(uint64 serverConnectionHandlerID, uint64 serverGroupID, uint64 clientDatabaseID, const char* clientNameIdentifier, const char* clientUniqueID);*/
+	void onChannelGroupListEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, const char* name, int type, int iconID, int saveDB);
 	virtual void on_channel_group_list(uint64 sch_id, uint64 channel_group_id, const char* name, int type, int icon_id, int save_db) {};
+	void onChannelGroupListFinishedEvent(uint64 serverConnectionHandlerID);
 	virtual void on_channel_group_list_finished(uint64 sch_id) {};
 	/*void onChannelGroupPermListEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, unsigned int permissionID, int permissionValue, int permissionNegated, int permissionSkip);
 	void onChannelGroupPermListFinishedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID);
@@ -119,17 +137,20 @@ public:
 	void onClientPermListEvent(uint64 serverConnectionHandlerID, uint64 clientDatabaseID, unsigned int permissionID, int permissionValue, int permissionNegated, int permissionSkip);
 	void onClientPermListFinishedEvent(uint64 serverConnectionHandlerID, uint64 clientDatabaseID);
 	void onChannelClientPermListEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 clientDatabaseID, unsigned int permissionID, int permissionValue, int permissionNegated, int permissionSkip);
-	void onChannelClientPermListFinishedEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 clientDatabaseID);
+	void onChannelClientPermListFinishedEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 clientDatabaseID);*/
 	void onClientChannelGroupChangedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, uint64 channelID, anyID clientID, anyID invokerClientID, const char* invokerName, const char* invokerUniqueIdentity);
-	int  onServerPermissionErrorEvent(uint64 serverConnectionHandlerID, const char* errorMessage, unsigned int error, const char* returnCode, unsigned int failedPermissionID);
+	virtual void on_client_channel_group_changed(uint64 sch_id, uint64 channel_group_id, uint64 channel_id, anyID client_id, anyID invoker_client_id, const char* invoker_name, const char* invoker_uid) {};
+	/*int  onServerPermissionErrorEvent(uint64 serverConnectionHandlerID, const char* errorMessage, unsigned int error, const char* returnCode, unsigned int failedPermissionID);
 	void onPermissionListGroupEndIDEvent(uint64 serverConnectionHandlerID, unsigned int groupEndID);
 	void onPermissionListEvent(uint64 serverConnectionHandlerID, unsigned int permissionID, const char* permissionName, const char* permissionDescription);
 	void onPermissionListFinishedEvent(uint64 serverConnectionHandlerID);
 	void onPermissionOverviewEvent(uint64 serverConnectionHandlerID, uint64 clientDatabaseID, uint64 channelID, int overviewType, uint64 overviewID1, uint64 overviewID2, unsigned int permissionID, int permissionValue, int permissionNegated, int permissionSkip);
-	void onPermissionOverviewFinishedEvent(uint64 serverConnectionHandlerID);
+	void onPermissionOverviewFinishedEvent(uint64 serverConnectionHandlerID);*/
 	void onServerGroupClientAddedEvent(uint64 serverConnectionHandlerID, anyID clientID, const char* clientName, const char* clientUniqueIdentity, uint64 serverGroupID, anyID invokerClientID, const char* invokerName, const char* invokerUniqueIdentity);
+	virtual void on_server_group_client_added(uint64 sch_id, anyID client_id, const char* client_name, const char* client_uid, uint64 server_group_id, anyID invoker_client_id, const char* invoker_name, const char* invoker_uid) {};
 	void onServerGroupClientDeletedEvent(uint64 serverConnectionHandlerID, anyID clientID, const char* clientName, const char* clientUniqueIdentity, uint64 serverGroupID, anyID invokerClientID, const char* invokerName, const char* invokerUniqueIdentity);
-	void onClientNeededPermissionsEvent(uint64 serverConnectionHandlerID, unsigned int permissionID, int permissionValue);
+	virtual void on_server_group_client_deleted(uint64 sch_id, anyID client_id, const char* client_name, const char* client_uid, uint64 server_group_id, anyID invoker_client_id, const char* invoker_name, const char* invoker_uid) {};
+	/*void onClientNeededPermissionsEvent(uint64 serverConnectionHandlerID, unsigned int permissionID, int permissionValue);
 	void onClientNeededPermissionsFinishedEvent(uint64 serverConnectionHandlerID);
 	void onFileTransferStatusEvent(anyID transferID, unsigned int status, const char* statusMessage, uint64 remotefileSize, uint64 serverConnectionHandlerID);
 	void onClientChatClosedEvent(uint64 serverConnectionHandlerID, anyID clientID, const char* clientUniqueIdentity);
@@ -165,6 +186,10 @@ private:
 	TSContextMenu* m_context_menu = nullptr;
 	TSInfoData* m_info_data = nullptr;
 	Talkers* m_talkers = nullptr;
+	EventRecorder* m_event_recorder = nullptr;
+	QTimer* m_error_summary_timer = nullptr;
+
+	bool is_recording() const { return m_event_recorder && m_event_recorder->is_recording(); }
 
 	anyID my_id_move_event(uint64 sch_id, anyID client_id, uint64 new_channel_id, int visibility);
 };
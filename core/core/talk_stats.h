@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QtCore/QtGlobal>
+#include <QtCore/QElapsedTimer>
+
+#include "teamspeak/public_definitions.h"
+
+// Per server and client talk activity: talk starts, total talk time, current burst
+// and talk time within rolling windows.
+// The windows are a ring of 15 s buckets covering an hour with running sums per window,
+// so an event costs O(1) (amortized over the buckets skipped) and only a client's
+// first talk allocates. Main thread only.
+class TalkStats
+{
+
+public:
+    enum Window
+    {
+        WINDOW_1MIN = 0,
+        WINDOW_5MIN,
+        WINDOW_60MIN,
+        WINDOW_COUNT
+    };
+
+    struct Stats
+    {
+        anyID client_id = 0;
+        quint32 talk_starts = 0;
+        quint64 total_ms = 0;
+        qint64 current_burst_ms = 0;    // 0 when not talking
+        std::array<quint32, WINDOW_COUNT> window_ms{};
+    };
+
+    TalkStats();
+
+    void onTalkStatusChange(uint64 sch_id, anyID client_id, bool is_talking);
+    void clear(uint64 sch_id);
+
+    bool stats(uint64 sch_id, anyID client_id, Stats* result);
+    double talk_share(uint64 sch_id, anyID client_id, Window window);    // 0..1 of the window length
+    std::vector<Stats> top_talkers(uint64 sch_id, Window window, int k);
+    std::vector<Stats> longest_bursts(uint64 sch_id, int k);     // open mic candidates
+
+    static qint64 window_length_ms(Window window);
+
+    void set_now_ms(qint64 now_ms) { m_now_ms = now_ms; }   // for replay / benchmarking; -1 uses the clock
+
+private:
+    static const int kBucketMs = 15000;
+    static const int kBucketCount = 240;
+    static const std::array<int, WINDOW_COUNT> kWindowBuckets;
+
+    struct Entry
+    {
+        quint32 talk_starts = 0;
+        quint64 total_ms = 0;
+        qint64 burst_start_ms = -1;     // -1: not talking
+        qint64 accounted_ms = 0;        // ongoing burst accounted into the buckets up to here
+        qint64 head = -1;               // absolute index of the newest bucket
+        std::array<quint16, kBucketCount> buckets{};
+        std::array<quint32, WINDOW_COUNT> window_ms{};
+    };
+    using ServerStats = std::unordered_map<anyID, Entry>;
+    std::unordered_map<uint64, std::unique_ptr<ServerStats> > m_servers;
+
+    QElapsedTimer m_clock;
+    qint64 m_now_ms = -1;
+    qint64 now_ms() const { return (m_now_ms < 0) ? m_clock.elapsed() : m_now_ms; }
+
+    static int slot(qint64 bucket) { return static_cast<int>(((bucket % kBucketCount) + kBucketCount) % kBucketCount); }
+    static void advance(Entry& entry, qint64 bucket);
+    static void account(Entry& entry, qint64 from_ms, qint64 to_ms);
+    static void sync(Entry& entry, qint64 now_ms);
+    static Stats to_stats(anyID client_id, const Entry& entry, qint64 now_ms);
+    Entry* find(uint64 sch_id, anyID client_id);
+};
@@ -2,20 +2,66 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QMultiMap>
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
 
 #include "teamspeak/public_definitions.h"
 
-#include <unordered_map>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include "module.h"
+#include "core/client_id_set.h"
+#include "core/talk_stats.h"
+
+struct TalkStatusChange
+{
+    anyID client_id;
+    int status;
+    bool is_received_whisper;
+    bool is_me;
+};
+Q_DECLARE_METATYPE(TalkStatusChange)
 
 class TalkInterface
 {
 public:
     virtual bool onTalkStatusChanged(uint64 serverConnectionHandlerID, int status, bool isReceivedWhisper, anyID clientID, bool itsMe) = 0;
+
+    // A batch of changes on one server, e.g. from Talkers::RefreshTalkers; stopped talkers come first.
+    // Override to handle them at once, the default delivers them one by one.
+    virtual void onTalkStatusChanges(uint64 serverConnectionHandlerID, const QVector<TalkStatusChange>& changes)
+    {
+        for (const auto& change : changes)
+            onTalkStatusChanged(serverConnectionHandlerID, change.status, change.is_received_whisper, change.client_id, change.is_me);
+    }
 };
 Q_DECLARE_INTERFACE(TalkInterface,"com.teamspeak.TalkInterface/1.0")
 
+// View of the talking state, published by Talkers after each change; immutable while pinned by a Talkers::SnapshotReader.
+// Client ids are ascending; servers are ordered by server connection handler id and may have empty lists.
+struct TalkersSnapshot
+{
+    struct Server
+    {
+        uint64 sch_id = 0;
+        std::vector<anyID> talkers;
+        std::vector<anyID> whisperers;
+    };
+    std::vector<Server> servers;
+    uint64 me_talking_sch_id = 0;   // 0 if I'm not talking
+    bool is_me_whispering = false;
+    quint64 generation = 0;
+
+    const Server* server(uint64 sch_id) const;
+    int talker_count(uint64 sch_id) const;
+    int whisperer_count(uint64 sch_id) const;
+    bool is_talking(uint64 sch_id, anyID client_id) const;
+    bool is_whispering(uint64 sch_id, anyID client_id) const;
+};
+
 class Talkers : public QObject
 {
     Q_OBJECT
@@ -24,6 +70,7 @@ class Talkers : public QObject
 
 public:
 	Talkers(QObject* parent = nullptr);
+    ~Talkers();
 
     bool onTalkStatusChangeEvent(uint64 serverConnectionHandlerID, int status, int isReceivedWhisper, anyID clientID);
     void onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus, unsigned int errorNumber);
@@ -32,18 +79,66 @@ public:
     const QMultiMap<uint64, anyID>& GetWhisperMap() const;
     uint64 isMeTalking() const;
 
+    // Pins the current snapshot while in scope; safe to use from any thread, e.g. the audio callbacks.
+    // A publish waits for the readers of the buffer it reuses, so keep the scope short (the current callback)
+    // and don't hold one on the main thread across calls that change the talking state.
+    class SnapshotReader
+    {
+    public:
+        explicit SnapshotReader(const Talkers& talkers);
+        ~SnapshotReader();
+        SnapshotReader(const SnapshotReader&) = delete;
+        SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+        const TalkersSnapshot& operator*() const { return *m_snapshot; }
+        const TalkersSnapshot* operator->() const { return m_snapshot; }
+
+    private:
+        std::atomic<int>* m_readers;
+        const TalkersSnapshot* m_snapshot;
+    };
+
     unsigned int RefreshTalkers(uint64 serverConnectionHandlerID);
     unsigned int RefreshAllTalkers();
 
     void DumpTalkStatusChanges(QObject* p, int status);
 
+    TalkStats& talk_stats() { return m_talk_stats; }
+
+    // TalkInterface implementers receiving the batches of RefreshTalkers
+    void RegisterTalkInterface(QObject* p);
+    void UnregisterTalkInterface(QObject* p);
+
 signals:
     void ConnectStatusChanged(uint64 serverConnectionHandlerID, int newStatus, unsigned int errorNumber);
+    void TalkStatusChanges(uint64 serverConnectionHandlerID, const QVector<TalkStatusChange>& changes);
 
 private:
     uint64 m_meTalkingScHandler = 0;
-    bool m_meTalkingIsWhisper;
+    bool m_meTalkingIsWhisper = false;
+
+    struct ServerTalkers
+    {
+        ClientIdSet talkers;
+        ClientIdSet whisperers;
+    };
+    std::map<uint64, std::unique_ptr<ServerTalkers> > m_servers;    // ordered, as the snapshot
+
+    // GetTalkerMap / GetWhisperMap adapters, rebuilt on demand
+    mutable QMultiMap<uint64, anyID> TalkerMap;
+    mutable QMultiMap<uint64, anyID> WhisperMap;
+    mutable bool m_is_maps_dirty = false;
+    void update_maps() const;
+
+    // Double buffer with a reader count per buffer: publish rebuilds the buffer not current, in place,
+    // once the readers that pinned it before the last switch are gone, then makes it current.
+    // The buffers keep their capacity, so a publish doesn't allocate once warm.
+    TalkersSnapshot m_snapshots[2];
+    std::atomic<int> m_current{0};
+    alignas(64) mutable std::atomic<int> m_readers[2];
+    void publish();
+
+    QVector<QPointer<QObject> > m_talk_interfaces;
 
-    QMultiMap<uint64, anyID> TalkerMap;
-    QMultiMap<uint64, anyID> WhisperMap;
+    TalkStats m_talk_stats;
 };
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "teamspeak/public_definitions.h"
+
+// Per server connection copy of the channel tree: parent, children, order and name,
+// plus a path to channel id hash. Built once on STATUS_CONNECTION_ESTABLISHED and kept current
+// from the channel events forwarded by Plugin_Base; dropped on disconnect.
+// TSHelpers' channel lookups use it when available. Main thread only.
+class TSChannelTree
+{
+
+public:
+    static TSChannelTree* instance() {
+        static QMutex mutex;
+        if(!m_Instance) {
+            mutex.lock();
+
+            if(!m_Instance)
+                m_Instance = new TSChannelTree;
+
+            mutex.unlock();
+        }
+        return m_Instance;
+    }
+
+    static void drop() {
+        static QMutex mutex;
+        mutex.lock();
+        delete m_Instance;
+        m_Instance = 0;
+        mutex.unlock();
+    }
+
+    // The convention of TSHelpers::GetChannelPath / GetChannelIDFromPath
+    static const QString kPathDelimiter;
+
+    // forwarded from Plugin_Base
+    void onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus);
+    void onNewChannelCreatedEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 channelParentID);
+    void onDelChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID);
+    void onChannelMoveEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 newChannelParentID);
+    void onUpdateChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID);
+
+    bool contains(uint64 serverConnectionHandlerID) const;
+
+    // ERROR_not_connected if the server isn't cached, ERROR_channel_invalid_id for unknown channels
+    unsigned int GetParentChannel(uint64 serverConnectionHandlerID, uint64 channelID, uint64* result) const;
+    unsigned int GetSubChannels(uint64 serverConnectionHandlerID, uint64 channelID, QVector<uint64>* result) const;
+    unsigned int GetChannelName(uint64 serverConnectionHandlerID, uint64 channelID, QString* result) const;
+    unsigned int GetChannelOrder(uint64 serverConnectionHandlerID, uint64 channelID, uint64* result) const;
+    unsigned int GetChannelPath(uint64 serverConnectionHandlerID, uint64 channelID, QString* result) const;
+    // A path shared by several channels resolves to the lowest channel id, independent of the event order
+    unsigned int GetChannelIDFromPath(uint64 serverConnectionHandlerID, const QString& path, uint64* result) const;
+
+private:
+    //singleton
+    TSChannelTree() = default;
+    ~TSChannelTree() = default;
+    TSChannelTree(const TSChannelTree &);
+    TSChannelTree& operator=(const TSChannelTree &);
+
+    static TSChannelTree* m_Instance;
+
+    struct Channel
+    {
+        uint64 parent_id = 0;
+        uint64 order = 0;
+        QString name;
+        QVector<uint64> children;
+    };
+
+    struct Server
+    {
+        QHash<uint64, Channel> channels;
+        QVector<uint64> roots;
+        mutable QHash<QString, uint64> paths;
+        mutable bool is_paths_dirty = true;
+    };
+    std::unordered_map<uint64, std::unique_ptr<Server> > m_servers;
+
+    unsigned int build(uint64 serverConnectionHandlerID);
+    unsigned int fetch(uint64 serverConnectionHandlerID, uint64 channelID, Channel* channel) const;
+    void link(Server& server, uint64 channelID, uint64 parentID);
+    void unlink(Server& server, uint64 channelID);
+    void remove(Server& server, uint64 channelID);
+    void rebuild_paths(const Server& server) const;
+    const Server* find(uint64 serverConnectionHandlerID) const;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "teamspeak/public_definitions.h"
+
+#include "core/group_set.h"
+
+// Per server connection table of the visible clients' channel, server groups, channel group,
+// channel commander flag, type and unique id. Filled on STATUS_CONNECTION_ESTABLISHED and kept
+// current from the move (incl. subscription, kick and ban), client update and group events forwarded by Plugin_Base;
+// dropped on disconnect. Like getClientList, it holds the clients visible to us. TSHelpers' whisper filtering uses it when available. Main thread only.
+// Server group and (channel group, channel) memberships are additionally indexed, so a group's
+// members are found in time proportional to the group's size.
+class TSClientTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    static TSClientTable* instance() {
+        static QMutex mutex;
+        if(!m_Instance) {
+            mutex.lock();
+
+            if(!m_Instance)
+                m_Instance = new TSClientTable;
+
+            mutex.unlock();
+        }
+        return m_Instance;
+    }
+
+    static void drop() {
+        static QMutex mutex;
+        mutex.lock();
+        delete m_Instance;
+        m_Instance = 0;
+        mutex.unlock();
+    }
+
+    struct Client
+    {
+        uint64 channel_id = 0;
+        uint64 channel_group_id = 0;
+        GroupSet server_groups;
+        bool is_channel_commander = false;
+        bool is_query = false;
+        QString unique_id;
+    };
+
+    // forwarded from Plugin_Base
+    void onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus);
+    // Any move, including timeouts, kicks, bans and the subscription moves; a client leaving our view is dropped
+    void onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility);
+    void onUpdateClientEvent(uint64 serverConnectionHandlerID, anyID clientID);
+    void onClientChannelGroupChangedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, anyID clientID);
+    void onServerGroupClientAddedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 serverGroupID);
+    void onServerGroupClientDeletedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 serverGroupID);
+
+    bool contains(uint64 serverConnectionHandlerID) const;
+    const Client* GetClient(uint64 serverConnectionHandlerID, anyID clientID) const;   // nullptr if unknown
+    QVector<anyID> GetClients(uint64 serverConnectionHandlerID) const;
+
+    // Members of a server group; nullptr if there are none
+    const QSet<anyID>* GetServerGroupClients(uint64 serverConnectionHandlerID, uint64 serverGroupID) const;
+    // Members of a channel group by channel; nullptr if there are none
+    const QHash<uint64, QSet<anyID> >* GetChannelGroupClients(uint64 serverConnectionHandlerID, uint64 channelGroupID) const;
+
+signals:
+    // After every change to a server's table, including it being built or dropped
+    void ClientsChanged(uint64 serverConnectionHandlerID);
+
+private:
+    //singleton
+    TSClientTable() = default;
+    ~TSClientTable() = default;
+    TSClientTable(const TSClientTable &);
+    TSClientTable& operator=(const TSClientTable &);
+
+    static TSClientTable* m_Instance;
+
+    struct Server
+    {
+        QHash<anyID, Client> clients;
+        QHash<uint64, QSet<anyID> > server_group_clients;
+        QHash<uint64, QHash<uint64, QSet<anyID> > > channel_group_clients; // channel group -> channel -> clients
+    };
+    std::unordered_map<uint64, std::unique_ptr<Server> > m_servers;
+
+    unsigned int build(uint64 serverConnectionHandlerID);
+    unsigned int fetch(uint64 serverConnectionHandlerID, anyID clientID, Client* client) const;
+    void index(Server* server, anyID clientID, const Client& client);
+    void unindex(Server* server, anyID clientID, const Client& client);
+    void unindex_server_group(Server* server, anyID clientID, uint64 serverGroupID);
+    void unindex_channel_group(Server* server, anyID clientID, const Client& client);
+    bool set_channel_group(Server* server, anyID clientID, Client* client, uint64 channelID, uint64 channelGroupID);
+    Server* find(uint64 serverConnectionHandlerID);
+    const Server* find(uint64 serverConnectionHandlerID) const;
+};
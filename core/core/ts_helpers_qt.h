@@ -11,6 +11,8 @@
 #include "teamspeak/public_definitions.h"
 #include "plugin_definitions.h"
 
+#include "core/group_set.h"
+
 namespace TSHelpers
 {
     QString GetConfigPath();
@@ -35,12 +37,17 @@ namespace TSHelpers
     int SetActiveServerRelative(uint64 serverConnectionHandlerID, bool next);
     inline int SetNextActiveServer(uint64 serverConnectionHandlerID) { return SetActiveServerRelative(serverConnectionHandlerID, true); }
     inline int SetPrevActiveServer(uint64 serverConnectionHandlerID) { return SetActiveServerRelative(serverConnectionHandlerID, false); }
+    // Channels and clients a group whisper resolves to, without me; no channels if resolved to clients
+    unsigned int GetWhisperTargets(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, uint64 arg, QVector<uint64>* targetChannels, QVector<anyID>* targetClients);
     unsigned int SetWhisperList(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, QString returnCode = QString::null, uint64 arg = (uint64)NULL);
 
     unsigned int GetDefaultProfile(PluginGuiProfile profile, QString &result);
 
     QWidget* GetMainWindow();
 
+    unsigned int GetClientServerGroups(uint64 serverConnectionHandlerID, anyID clientID, GroupSet *result);
+    unsigned int GetClientSelfServerGroups(uint64 serverConnectionHandlerID, GroupSet *result);
+    // QSet adapters; these add to result
     unsigned int GetClientServerGroups(uint64 serverConnectionHandlerID, anyID clientID, QSet<uint64> *result);
     unsigned int GetClientSelfServerGroups(uint64 serverConnectionHandlerID, QSet<uint64> *result);
     unsigned int GetClientChannelGroup(uint64 serverConnectionHandlerID, uint64* result, anyID clientId = (anyID)NULL);
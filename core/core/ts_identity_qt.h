@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+#include "teamspeak/public_definitions.h"
+
+// Per server connection cache of our own client id, channel and channel group.
+// Populated on STATUS_CONNECTION_ESTABLISHED, kept current from our own moves (incl. kicks and bans) and
+// channel group changes, cleared on disconnect. Falls back to the api when nothing is cached.
+// Main thread only.
+class TSIdentity
+{
+
+public:
+    static TSIdentity* instance() {
+        static QMutex mutex;
+        if(!m_Instance) {
+            mutex.lock();
+
+            if(!m_Instance)
+                m_Instance = new TSIdentity;
+
+            mutex.unlock();
+        }
+        return m_Instance;
+    }
+
+    static void drop() {
+        static QMutex mutex;
+        mutex.lock();
+        delete m_Instance;
+        m_Instance = 0;
+        mutex.unlock();
+    }
+
+    // forwarded from Plugin_Base
+    void onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus);
+    void onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 newChannelID);
+    void onClientChannelGroupChangedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, anyID clientID);
+    void clear(uint64 serverConnectionHandlerID);
+
+    unsigned int GetMyId(uint64 serverConnectionHandlerID, anyID* result);
+    unsigned int GetMyChannel(uint64 serverConnectionHandlerID, uint64* result);
+    unsigned int GetMyChannelGroup(uint64 serverConnectionHandlerID, uint64* result);
+    bool IsMe(uint64 serverConnectionHandlerID, anyID clientID);
+
+private:
+    //singleton
+    TSIdentity() = default;
+    ~TSIdentity() = default;
+    TSIdentity(const TSIdentity &);
+    TSIdentity& operator=(const TSIdentity &);
+
+    static TSIdentity* m_Instance;
+
+    struct Identity
+    {
+        anyID my_id = 0;
+        uint64 channel_id = 0;
+        uint64 channel_group_id = 0;    // 0: not known yet
+    };
+    QHash<uint64, Identity> m_identities;
+};
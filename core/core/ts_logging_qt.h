@@ -4,24 +4,161 @@
 #define PATH_BUFSIZE 512
 #endif
 
+#include <type_traits>
+
 #include <QtCore/QString>
 
 #include "teamspeak/public_definitions.h"
 
+#include "core/error_limiter.h"
+
+// The least important level compiled into TS_LOG; lower levels (in TSLogging::Rank order) are stripped.
+// Release builds keep LogLevel_INFO and up, override with -DTS_LOG_COMPILED_LEVEL=LogLevel_...
+#ifndef TS_LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define TS_LOG_COMPILED_LEVEL LogLevel_INFO
+#else
+#define TS_LOG_COMPILED_LEVEL LogLevel_DEVEL
+#endif
+#endif
+
+// True if a message of level would be logged; use it to guard building expensive messages
+#define TS_LOG_ENABLED(level) (TSLogging::IsCompiledIn(level) && TSLogging::IsLogged(level))
+
+// TS_LOG(serverConnectionHandlerID, level, "format %1 %2", args...)
+// The arguments are only evaluated if the level is enabled. The format must be a string literal
+// (see TSLogging::LogFormatString), the async backend keeps the pointer and formats on its thread.
+#define TS_LOG(serverConnectionHandlerID, level, ...) \
+    do { if (TS_LOG_ENABLED(level)) TSLogging::LogFormat(serverConnectionHandlerID, level, __VA_ARGS__); } while (0)
+#define TS_LOG_DEBUG(serverConnectionHandlerID, ...) TS_LOG(serverConnectionHandlerID, LogLevel_DEBUG, __VA_ARGS__)
+#define TS_LOG_DEVEL(serverConnectionHandlerID, ...) TS_LOG(serverConnectionHandlerID, LogLevel_DEVEL, __VA_ARGS__)
+
+// TS_ERROR(message, serverConnectionHandlerID, error[, isSoundSilent]) or TS_ERROR(message, isSoundSilent) for messages built at runtime:
+// rate limited by the source location instead of the message
+#define TS_CALL_SITE (ErrorLimiter::CallSite{__FILE__, __LINE__})
+#define TS_ERROR(...) TSLogging::Error(TS_CALL_SITE, __VA_ARGS__)
+
 namespace TSLogging
 {
+    // Importance order of the levels, CRITICAL = 0 ... DEVEL = 5; the sdk enum has DEBUG before INFO
+    constexpr int Rank(LogLevel logLevel)
+    {
+        return (logLevel == LogLevel_INFO) ? 3 : (logLevel == LogLevel_DEBUG) ? 4 : static_cast<int>(logLevel);
+    }
+    constexpr bool IsCompiledIn(LogLevel logLevel)                                              {return Rank(logLevel) <= Rank(TS_LOG_COMPILED_LEVEL);}
+
+    // Runtime filter for Log, LogFormat and TS_LOG; Error is never filtered.
+    // Defaults to LogLevel_DEVEL, i.e. off: only TS_LOG is stripped at compile time.
+    void SetLogLevel(LogLevel logLevel);
+    LogLevel GetLogLevel();
+    bool IsLogged(LogLevel logLevel);
+
+    // A raw argument of a deferred log message, formatted as by QString::arg.
+    // Strings are referenced and copied by the backend.
+    struct LogArg
+    {
+        enum Type : quint8
+        {
+            kInt,
+            kUInt,
+            kDouble,
+            kString,
+            kUtf8
+        };
+
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+        LogArg(T value) : type(kInt), i(value) {}
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, int>::type = 0>
+        LogArg(T value) : type(kUInt), u(value) {}
+        template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+        LogArg(T value) : type(kInt), i(static_cast<qint64>(value)) {}
+        LogArg(double value) : type(kDouble), d(value) {}
+        LogArg(const QString& value) : type(kString), s(&value) {}
+        LogArg(const char* value) : type(kUtf8), c(value) {}
+
+        QString toString() const;
+
+        Type type;
+        union
+        {
+            qint64 i;
+            quint64 u;
+            double d;
+            const QString* s;
+            const char* c;
+        };
+    };
+
+    // The format of a deferred message. The async backend keeps the pointer until its thread formats the message,
+    // so only string literals convert; a buffer or a pointer doesn't compile.
+    struct LogFormatString
+    {
+        template <size_t N>
+        LogFormatString(const char (&format)[N]) : c(format) {}
+        template <size_t N>
+        LogFormatString(char (&format)[N]) = delete;
+
+        const char* c;
+    };
+
+    // Replaces %1 ... %9 in one pass, so arguments containing %n are left alone
+    QString Format(const char* format, const QString* args, int count);
+
+    void LogArgs(uint64 serverConnectionHandlerID, LogLevel logLevel, LogFormatString format, const LogArg* args, int count);
+    inline void LogFormat(uint64 serverConnectionHandlerID, LogLevel logLevel, LogFormatString format)  {LogArgs(serverConnectionHandlerID, logLevel, format, nullptr, 0);}
+    template <typename Arg, typename... Args>
+    void LogFormat(uint64 serverConnectionHandlerID, LogLevel logLevel, LogFormatString format, const Arg& arg, const Args&... args)
+    {
+        const LogArg kArgs[] = {LogArg(arg), LogArg(args)...};
+        LogArgs(serverConnectionHandlerID, logLevel, format, kArgs, 1 + sizeof...(Args));
+    }
+
     bool GetErrorSound(QString &in);
     bool GetInfoIcon(QString &in);
     void PlayErrorSound(uint64 serverConnectionHandlerID = 0);
 
+    // Repeats from the same call site with the same error are rate limited, see ErrorLimiter.
+    // A string literal message is its own call site; a message built at runtime needs TS_ERROR, which passes __FILE__ and __LINE__,
+    // otherwise it isn't limited.
+    void Error(const ErrorLimiter::CallSite& callSite, QString message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent = false);
+    inline void Error(const ErrorLimiter::CallSite& callSite, QString message, bool isSoundSilent)   {Error(callSite, message, 0, NULL, isSoundSilent);}
     void Error(QString message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent = false);
     inline void Error(QString message, unsigned int error)                                      {Error(message, 0, error, false);}
     inline void Error(QString message, bool isSoundSilent)                                      {Error(message, 0, NULL, isSoundSilent);}
     inline void Error(QString message)                                                          {Error(message, 0, NULL, false);}
 
+    // Literal messages; in async mode they're queued by pointer, without building a QString
+    void ErrorLiteral(const char* message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent);
+    template <size_t N>
+    void Error(const char (&message)[N], uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent = false)   {ErrorLiteral(message, serverConnectionHandlerID, error, isSoundSilent);}
+    template <size_t N>
+    void Error(const char (&message)[N], unsigned int error)                                    {ErrorLiteral(message, 0, error, false);}
+    template <size_t N>
+    void Error(const char (&message)[N], bool isSoundSilent)                                    {ErrorLiteral(message, 0, NULL, isSoundSilent);}
+    template <size_t N>
+    void Error(const char (&message)[N])                                                        {ErrorLiteral(message, 0, NULL, false);}
+    // A mutable buffer is no literal
+    template <size_t N, typename... Args>
+    void Error(char (&message)[N], Args... args)                                                {Error(QString::fromUtf8(message), args...);}
+
     void Print(QString message, uint64 serverConnectionHandlerID = 0, LogLevel logLevel = LogLevel_INFO);
     inline void Print(QString message, LogLevel logLevel)                                       {Print(message, 0, logLevel);}
 
     void Log(QString message, uint64 serverConnectionHandlerID = 0, LogLevel logLevel = LogLevel_INFO);
     inline void Log(QString message, LogLevel logLevel)                                         {Log(message, 0, logLevel);}
+
+    // Every rate limited Error call by call site and error, reported or suppressed
+    QVector<ErrorLimiter::Counter> GetErrorCounters();
+    // Logs a summary per call site with errors suppressed since its last report; Plugin_Base calls it every ErrorLimiter::kRefillMs
+    void FlushSuppressedErrors();
+
+    // The error sound and chat print part of Error; main thread only
+    void PrintError(QString message, uint64 serverConnectionHandlerID, bool isSoundSilent);
+
+    // Async mode: Log and Error queue the message and return, a background thread writes it to the client log.
+    // Toggle from the main thread; a plugin enabling it must disable it again in shutdown.
+    // If the queue is full, messages are dropped and counted.
+    bool SetAsync(bool isAsync);
+    bool IsAsync();
+    quint64 GetDroppedCount();
 }
@@ -5,8 +5,26 @@
 #include "teamspeak/public_definitions.h"
 
 #include "ts_servergroups.h"
+#include "core/group_set.h"
 
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QMetaType>
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+// Changes between two versions of a server's or channel group list
+struct GroupListDelta
+{
+    QMap<uint64, QString> added;
+    QList<uint64> removed;
+    QMap<uint64, QString> renamed;  // the new names
+
+    bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && renamed.isEmpty(); }
+    static GroupListDelta diff(const QMap<uint64, QString>& before, const QMap<uint64, QString>& after);
+};
+Q_DECLARE_METATYPE(GroupListDelta)
 
 class TSServerInfo : public QObject
 {
@@ -25,6 +43,16 @@ public:
     QString getUniqueId() const;
     uint64 getDefaultChannelGroup() const;
 
+    // Caches name, unique id and default channel group; called by TSServersInfo
+    // on connection established and server updated. Until then the getters ask the client.
+    void refresh();
+    bool is_cached() const { return m_is_cached; }
+
+    // Loads the group lists last seen on this server from the GroupCache, unless they
+    // have been received already; called by TSServersInfo while connecting.
+    // The live lists are then diffed against them like any other refresh.
+    void load_group_cache();
+
     // forwards from plugin.cpp
     void onServerGroupListEvent(uint64 server_group_id, const char* name, int type, int icon_id, int save_db);
     void onServerGroupListFinishedEvent();
@@ -36,15 +64,58 @@ public:
     uint64 GetChannelGroupId(QString name) const;
     QString GetChannelGroupName(uint64 id) const;
 
+    // Ids of the named groups, e.g. to match against a client's groups with GroupSet::intersects;
+    // unknown names are skipped
+    GroupSet GetServerGroupIds(const QStringList& names) const;
+    GroupSet GetChannelGroupIds(const QStringList& names) const;
+
 signals:
+    // The delta is emitted when a list has changed, whether loaded from the cache or received live.
+    // The whole list follows it for listeners that rebuild from scratch. TSServersInfo forwards the signals from
+    // before the cache load on, so a first live list equal to the cache emits nothing; without a cache
+    // the first live list is emitted in any case.
     void serverGroupListUpdated(uint64 server_connection_id, QMap<uint64, QString>);
     void channelGroupListUpdated(uint64 server_connection_id, QMap<uint64, QString>);
+    void serverGroupListDelta(uint64 server_connection_id, const GroupListDelta& delta);
+    void channelGroupListDelta(uint64 server_connection_id, const GroupListDelta& delta);
 
 private:
     uint64 m_server_connection_id;
 
+    bool m_is_cached = false;
+    QString m_name;
+    QString m_unique_id;
+    uint64 m_default_channel_group = 0;
+
+    QString fetch_name() const;
+    QString fetch_unique_id() const;
+    uint64 fetch_default_channel_group() const;
+
+    // lookups use the current lists while the next ones are received
     QMap<uint64, QString> m_server_groups;
+    QMap<uint64, QString> m_server_groups_pending;
     bool m_is_server_groups_updating = false;
+    bool m_is_server_groups_live = false;
     QMap<uint64, QString> m_channel_groups;
+    QMap<uint64, QString> m_channel_groups_pending;
     bool m_is_channel_groups_updating = false;
+    bool m_is_channel_groups_live = false;
+    bool m_is_group_cache_loaded = false;
+
+    void save_group_cache();
+
+    // Lookup indexes over a finished group list; the keys share the names' data.
+    // Names are matched exactly first, then case folded.
+    struct GroupIndex
+    {
+        QHash<uint64, QString> names;
+        QHash<QString, uint64> ids;
+        QHash<QString, uint64> folded_ids;
+
+        void build(const QMap<uint64, QString>& groups, bool is_prefer_highest_id);
+        uint64 id(const QString& name) const;
+        QString name(uint64 id) const;
+    };
+    GroupIndex m_server_group_index;
+    GroupIndex m_channel_group_index;
 };
@@ -2,6 +2,7 @@
 
 #include "ts_serverinfo_qt.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 
@@ -17,6 +18,7 @@ public:
 
     // forwarded from plugin.cpp
     void onConnectStatusChangeEvent(uint64 server_connection_id, int new_status, unsigned int error_number);
+    void onServerUpdatedEvent(uint64 server_connection_id);
 
     void onServerGroupListEvent(uint64 server_connection_id, uint64 server_group_id, const char* name, int type, int icon_id, int save_db);
     void onServerGroupListFinishedEvent(uint64 server_connection_id);
@@ -27,7 +29,16 @@ signals:
     void connectStatusChanged(uint64 server_connection_id, int new_status, unsigned int error_number);
 
     void serverGroupListUpdated(uint64 server_connection_id, QMap<uint64,QString>);
+    void serverGroupListDelta(uint64 server_connection_id, const GroupListDelta& delta);
+    void channelGroupListUpdated(uint64 server_connection_id, QMap<uint64,QString>);
+    void channelGroupListDelta(uint64 server_connection_id, const GroupListDelta& delta);
 
 private:
     QMap<uint64, QPointer<TSServerInfo> > m_server_infos;
+
+    // unique id -> server connection of the connected servers;
+    // seeded from the handler list on first use for connections made before we were loaded
+    QHash<QString, uint64> m_unique_ids;
+    bool m_is_unique_ids_seeded = false;
+    void update_unique_id(uint64 server_connection_id, const QString& unique_id);
 };
@@ -13,6 +13,8 @@
 #include <QtSql/QtSql>
 #include <QtCore/QMutex>
 
+class QFileSystemWatcher;
+
 class TSSettings
 {
 
@@ -41,6 +43,8 @@ public:
 
     void Init(QString tsConfigPath);
 
+    // The getters read from an in-memory snapshot of the tables they use, loaded on first use.
+    // The snapshot is reloaded when settings.db or its WAL change on disk.
     bool GetSoundPack(QString& result);
     bool GetIconPack(QString& result);
     bool GetDefaultCaptureProfile(QString& result);
@@ -56,21 +60,57 @@ public:
     bool Is3DSoundEnabled(bool &result);
     bool Set3DSoundEnabled(bool val);
 
+    bool Refresh();     // reloads the snapshot now, for callers needing the latest value
+    quint64 GetSnapshotGeneration();
+
     QSqlError GetLastError();
 
 private:
     //singleton
     explicit TSSettings();
-    ~TSSettings() = default;
+    ~TSSettings();
     static TSSettings* m_Instance;
     TSSettings(const TSSettings &);
     TSSettings& operator=(const TSSettings &);
 
     QMap<QString,QString> GetMapFromValue(QString value);
+    typedef QVector<QPair<QString, QString> > Rows;
     bool GetValueFromQuery(QString query, QString &result, bool isEmptyValid);
-    bool GetValuesFromQuery(QString query, QStringList &result);
+    bool GetRowsFromQuery(QString query, Rows &result);
     void SetError(QString in);   //create Custom SQL Error Helper
     QSqlError error_qsql;
 
+    // One read-only connection, opened on the first query; statements are prepared once
     QSqlDatabase m_SettingsDb;
+    QString m_SettingsDbPath;
+    QString m_ConnectionName;
+    QMutex m_db_mutex;
+    QHash<QString, QSqlQuery*> m_statements;
+    bool OpenDatabase();
+    QSqlQuery* GetStatement(const QString& query);
+
+    // Releases the statement's read lock on settings.db once the result is read
+    struct StatementFinisher
+    {
+        QSqlQuery& query;
+        ~StatementFinisher() { query.finish(); }
+    };
+
+    struct SnapshotTable
+    {
+        Rows rows;  // key, value in table order
+        QHash<QString, int> index;
+    };
+    QMutex m_cache_mutex;   // before m_db_mutex
+    QHash<QString, SnapshotTable> m_snapshot;
+    quint64 m_snapshot_generation = 0;
+    QString m_data_version;
+    bool GetValueFromSnapshot(const QString& table, const QString& key, QString& result, bool isEmptyValid);
+    bool GetValuesFromSnapshot(const QString& table, QStringList& result);
+    const SnapshotTable* GetSnapshotTable(const QString& table);
+    bool LoadSnapshotTable(const QString& table, SnapshotTable& result);
+    bool ReloadSnapshot(bool isForced);
+
+    QFileSystemWatcher* m_watcher = nullptr;
+    void onSettingsFileChanged(const QString& path);
 };
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+#include "teamspeak/public_definitions.h"
+
+// A group whisper target that stays current. It resolves like TSHelpers::SetWhisperList,
+// then follows TSClientTable's changes on its server and pushes a new whisper list only
+// when the resolved channels or clients differ from the last ones pushed.
+// Changes are coalesced for kDebounceMs; after a reconnect the list is pushed again.
+// When nobody is left to whisper to, the whisper list is cleared and TargetsChanged is emitted
+// with empty lists: the server then sends our voice to our own channel, so owners that
+// transmit on a whisper key should stop doing so. Without a client table for the server
+// (it failed to build), changes aren't signalled; the targets are then polled every kPollMs.
+// Main thread only.
+class WhisperTarget : public QObject
+{
+    Q_OBJECT
+
+public:
+    WhisperTarget(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, uint64 arg = 0, QObject* parent = nullptr);
+
+    static const int kDebounceMs = 250;
+    static const int kPollMs = 2000;
+
+    uint64 server_connection_handler_id() const { return m_sch_id; }
+    bool is_active() const { return m_is_active; }
+
+    // ascending, as last pushed
+    const QVector<uint64>& target_channels() const { return m_channels; }
+    const QVector<anyID>& target_clients() const { return m_clients; }
+
+    // Resolves and pushes right away, then keeps the whisper list current until stop()
+    unsigned int start();
+    // Stops following changes; the whisper list last pushed stays in place
+    void stop();
+
+signals:
+    void TargetsChanged(uint64 serverConnectionHandlerID, const QVector<uint64>& channels, const QVector<anyID>& clients);
+
+private slots:
+    void onClientsChanged(uint64 serverConnectionHandlerID);
+    void refresh();
+    void poll();
+
+private:
+    const uint64 m_sch_id;
+    const GroupWhisperType m_type;
+    const GroupWhisperTargetMode m_mode;
+    const uint64 m_arg;
+
+    bool m_is_active = false;
+    bool m_is_pushed = false;
+    QVector<uint64> m_channels;
+    QVector<anyID> m_clients;
+    QTimer m_debounce;
+    QTimer m_poll;
+
+    unsigned int update(bool force);
+};
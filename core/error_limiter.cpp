@@ -0,0 +1,122 @@
+#include "core/error_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+static_assert((ErrorLimiter::kMaxKeys & (ErrorLimiter::kMaxKeys - 1)) == 0, "ErrorLimiter::kMaxKeys must be a power of two");
+
+qint64 ErrorLimiter::now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// splitmix64 over the site pointer, line and error; never 0, that marks a free slot
+quint64 ErrorLimiter::hash(const CallSite& call_site, unsigned int error)
+{
+    quint64 x = static_cast<quint64>(reinterpret_cast<std::uintptr_t>(call_site.site));
+    x ^= (static_cast<quint64>(static_cast<quint32>(call_site.line)) << 32) | error;
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x ? x : 1;
+}
+
+ErrorLimiter::Entry* ErrorLimiter::find_or_claim(const CallSite& call_site, unsigned int error, qint64 now)
+{
+    const auto kKey = hash(call_site, error);
+    for (int i = 0; i < kMaxKeys; ++i)
+    {
+        auto& entry = m_entries[(kKey + i) & (kMaxKeys - 1)];
+        auto key = entry.key.load(std::memory_order_acquire);
+        if (key == 0)
+        {
+            if (entry.key.compare_exchange_strong(key, kKey, std::memory_order_acq_rel))
+            {
+                entry.call_site = call_site;
+                entry.error = error;
+                entry.first_ms.store(now, std::memory_order_relaxed);
+                entry.is_ready.store(true, std::memory_order_release);
+                return &entry;
+            }
+            // lost the race; key is the winner's now
+        }
+        if (key == kKey)
+            return &entry;
+    }
+    return nullptr;
+}
+
+bool ErrorLimiter::admit(const CallSite& call_site, unsigned int error, quint64* suppressed_since)
+{
+    *suppressed_since = 0;
+    if (!call_site.site)
+        return true;
+
+    const auto kNow = now_ms();
+    auto entry = find_or_claim(call_site, error, kNow);
+    if (!entry)
+    {
+        m_untracked.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    entry->count.fetch_add(1, std::memory_order_relaxed);
+    entry->last_ms.store(kNow, std::memory_order_relaxed);
+
+    // GCRA: each report pushes tat_ms one interval ahead; more than kBurst - 1 intervals ahead means the bucket is empty
+    const qint64 kInterval = kRefillMs;
+    const qint64 kTolerance = qint64(kBurst - 1) * kRefillMs;
+    auto tat = entry->tat_ms.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        const auto kStart = std::max(tat, kNow);
+        if (kStart - kNow > kTolerance)
+        {
+            entry->suppressed.fetch_add(1, std::memory_order_relaxed);
+            entry->pending.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (entry->tat_ms.compare_exchange_weak(tat, kStart + kInterval, std::memory_order_relaxed))
+            break;
+    }
+
+    *suppressed_since = entry->pending.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+QVector<ErrorLimiter::Pending> ErrorLimiter::take_pending()
+{
+    QVector<Pending> result;
+    for (auto& entry : m_entries)
+    {
+        if (!entry.is_ready.load(std::memory_order_acquire))
+            continue;
+
+        const auto kPending = entry.pending.exchange(0, std::memory_order_relaxed);
+        if (kPending > 0)
+            result.append({entry.call_site, entry.error, kPending});
+    }
+    return result;
+}
+
+QVector<ErrorLimiter::Counter> ErrorLimiter::counters() const
+{
+    QVector<Counter> result;
+    for (const auto& entry : m_entries)
+    {
+        if (!entry.is_ready.load(std::memory_order_acquire))
+            continue;
+
+        result.append({entry.call_site,
+                       entry.error,
+                       entry.count.load(std::memory_order_relaxed),
+                       entry.suppressed.load(std::memory_order_relaxed),
+                       entry.first_ms.load(std::memory_order_relaxed),
+                       entry.last_ms.load(std::memory_order_relaxed)});
+    }
+
+    std::sort(result.begin(), result.end(), [](const Counter& a, const Counter& b) { return a.count > b.count; });
+    return result;
+}
@@ -0,0 +1,278 @@
+#include "core/event_recorder.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <QtCore/QMutexLocker>
+
+#include "core/ts_logging_qt.h"
+
+const char* EventTrace::type_name(Type type)
+{
+    switch (type)
+    {
+    case Type::ConnectStatus:
+        return "connect_status";
+    case Type::Identity:
+        return "identity";
+    case Type::ClientMove:
+        return "client_move";
+    case Type::ClientMoveTimeout:
+        return "client_move_timeout";
+    case Type::ClientMoveMoved:
+        return "client_move_moved";
+    case Type::TalkStatus:
+        return "talk_status";
+    case Type::ServerGroupList:
+        return "server_group_list";
+    case Type::ServerGroupListFinished:
+        return "server_group_list_finished";
+    case Type::ChannelGroupList:
+        return "channel_group_list";
+    case Type::ChannelGroupListFinished:
+        return "channel_group_list_finished";
+    case Type::PlaybackPreProcess:
+        return "playback_pre_process";
+    case Type::PlaybackPostProcess:
+        return "playback_post_process";
+    default:
+        return "unknown";
+    }
+}
+
+static_assert((EventRecorder::kVoiceCapacity & (EventRecorder::kVoiceCapacity - 1)) == 0, "EventRecorder::kVoiceCapacity must be a power of two");
+
+EventRecorder::EventRecorder(QObject* parent)
+    : QObject(parent)
+{
+    for (int i = 0; i < kVoiceCapacity; ++i)
+        m_voice_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+EventRecorder::~EventRecorder()
+{
+    stop();
+}
+
+//! Start writing a trace, replacing the file if it exists
+/*!
+ * \brief EventRecorder::start
+ * \param file_path the trace file
+ * \param voice whether to record voice buffer events and their samples
+ * \return true on success
+ */
+bool EventRecorder::start(const QString& file_path, EventTrace::Voice voice)
+{
+    stop();
+
+    QMutexLocker locker(&m_mutex);
+    m_file.setFileName(file_path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        TS_ERROR(QString("(EventRecorder::start) Could not open %1: %2").arg(file_path).arg(m_file.errorString()), true);
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_5_0);
+    m_stream << EventTrace::kMagic << EventTrace::kVersion << static_cast<quint8>(voice);
+
+    if (voice == EventTrace::Voice::Samples && m_voice_samples.size() < static_cast<size_t>(kVoiceCapacity) * kVoiceMaxSamples)
+        m_voice_samples.resize(static_cast<size_t>(kVoiceCapacity) * kVoiceMaxSamples);
+    m_voice_dropped.store(0, std::memory_order_relaxed);
+    m_voice.store(voice, std::memory_order_relaxed);
+    m_timer.start();
+    m_is_recording.store(true);
+    if (voice != EventTrace::Voice::None)
+    {
+        m_is_voice_stopping.store(false, std::memory_order_relaxed);
+        m_voice_thread = std::thread(&EventRecorder::run_voice, this);
+    }
+    TSLogging::Log(QString("(EventRecorder) Recording to %1").arg(file_path));
+    return true;
+}
+
+void EventRecorder::stop()
+{
+    if (!m_is_recording.exchange(false))
+        return;
+
+    // the audio threads that still saw the recording on finish their records
+    while (m_voice_writers.load() > 0)
+        std::this_thread::yield();
+
+    if (m_voice_thread.joinable())
+    {
+        m_is_voice_stopping.store(true, std::memory_order_release);
+        m_voice_thread.join();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    drain_voice();
+    m_stream.setDevice(nullptr);
+    m_file.close();
+    const auto kDropped = m_voice_dropped.load(std::memory_order_relaxed);
+    if (kDropped > 0)
+        TSLogging::Log(QString("(EventRecorder) %1 voice records dropped.").arg(kDropped), LogLevel_WARNING);
+    TSLogging::Log("(EventRecorder) Recording stopped.");
+}
+
+void EventRecorder::record_connect_status(uint64 sch_id, int new_status, unsigned int error_number)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!is_recording())
+        return;
+
+    drain_voice();
+    write_head(EventTrace::Type::ConnectStatus, sch_id);
+    m_stream << static_cast<qint32>(new_status) << static_cast<quint32>(error_number);
+}
+
+void EventRecorder::record_identity(uint64 sch_id, anyID my_id, uint64 channel_id)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!is_recording())
+        return;
+
+    drain_voice();
+    write_head(EventTrace::Type::Identity, sch_id);
+    m_stream << static_cast<quint16>(my_id) << static_cast<quint64>(channel_id);
+}
+
+void EventRecorder::record_client_move(EventTrace::Type type, uint64 sch_id, anyID client_id, uint64 old_channel_id, uint64 new_channel_id, int visibility, anyID mover_id)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!is_recording())
+        return;
+
+    drain_voice();
+    write_head(type, sch_id);
+    m_stream << static_cast<quint16>(client_id) << static_cast<quint64>(old_channel_id) << static_cast<quint64>(new_channel_id) << static_cast<qint32>(visibility);
+    if (type == EventTrace::Type::ClientMoveMoved)
+        m_stream << static_cast<quint16>(mover_id);
+}
+
+void EventRecorder::record_talk_status(uint64 sch_id, int status, int is_received_whisper, anyID client_id)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!is_recording())
+        return;
+
+    drain_voice();
+    write_head(EventTrace::Type::TalkStatus, sch_id);
+    m_stream << static_cast<qint32>(status) << static_cast<qint32>(is_received_whisper) << static_cast<quint16>(client_id);
+}
+
+void EventRecorder::record_group_list(EventTrace::Type type, uint64 sch_id, uint64 group_id, const char* name, int group_type)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!is_recording())
+        return;
+
+    drain_voice();
+    write_head(type, sch_id);
+    m_stream << static_cast<quint64>(group_id) << QByteArray(name) << static_cast<qint32>(group_type);
+}
+
+void EventRecorder::record_group_list_finished(EventTrace::Type type, uint64 sch_id)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!is_recording())
+        return;
+
+    drain_voice();
+    write_head(type, sch_id);
+}
+
+void EventRecorder::record_voice(EventTrace::Type type, uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels)
+{
+    if (!is_recording())
+        return;
+
+    // pairs with stop(): either it sees this writer, or this writer sees the recording off
+    m_voice_writers.fetch_add(1);
+    if (m_is_recording.load())
+    {
+        const auto kVoice = m_voice.load(std::memory_order_relaxed);
+        if (kVoice != EventTrace::Voice::None)
+            push_voice(kVoice, type, sch_id, client_id, samples, frame_count, channels);
+    }
+    m_voice_writers.fetch_sub(1, std::memory_order_release);
+}
+
+void EventRecorder::push_voice(EventTrace::Voice voice, EventTrace::Type type, uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels)
+{
+    const auto kSampleCount = frame_count * channels;
+    const auto kIsSamples = (voice == EventTrace::Voice::Samples);
+    if (kIsSamples && kSampleCount > kVoiceMaxSamples)
+    {
+        m_voice_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto pos = m_voice_enqueue_pos.load(std::memory_order_relaxed);
+    VoiceSlot* slot;
+    for (;;)
+    {
+        slot = &m_voice_slots[pos & (kVoiceCapacity - 1)];
+        const auto kDiff = static_cast<qint64>(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (kDiff == 0)
+        {
+            if (m_voice_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (kDiff < 0)
+        {
+            // full; the writer hasn't caught up
+            m_voice_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+            pos = m_voice_enqueue_pos.load(std::memory_order_relaxed);
+    }
+
+    slot->record = {static_cast<quint64>(m_timer.nsecsElapsed()), sch_id, type, client_id, frame_count, channels};
+    if (kIsSamples)
+        std::memcpy(&m_voice_samples[(pos & (kVoiceCapacity - 1)) * kVoiceMaxSamples], samples, kSampleCount * sizeof(short));
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void EventRecorder::drain_voice()
+{
+    const auto kVoice = m_voice.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        const auto kIndex = m_voice_dequeue_pos & (kVoiceCapacity - 1);
+        auto& slot = m_voice_slots[kIndex];
+        if (slot.sequence.load(std::memory_order_acquire) != m_voice_dequeue_pos + 1)
+            break;
+
+        const auto& kRecord = slot.record;
+        write_head(kRecord.type, kRecord.nsecs, kRecord.sch_id);
+        m_stream << static_cast<quint16>(kRecord.client_id) << static_cast<qint32>(kRecord.frame_count) << static_cast<qint32>(kRecord.channels);
+        if (kVoice == EventTrace::Voice::Samples)
+            m_stream.writeRawData(reinterpret_cast<const char*>(&m_voice_samples[kIndex * kVoiceMaxSamples]), kRecord.frame_count * kRecord.channels * static_cast<int>(sizeof(short)));
+
+        slot.sequence.store(m_voice_dequeue_pos + kVoiceCapacity, std::memory_order_release);
+        ++m_voice_dequeue_pos;
+    }
+}
+
+void EventRecorder::run_voice()
+{
+    while (!m_is_voice_stopping.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(kVoiceDrainMs)));
+        QMutexLocker locker(&m_mutex);
+        drain_voice();
+    }
+}
+
+void EventRecorder::write_head(EventTrace::Type type, uint64 sch_id)
+{
+    write_head(type, static_cast<quint64>(m_timer.nsecsElapsed()), sch_id);
+}
+
+void EventRecorder::write_head(EventTrace::Type type, quint64 nsecs, uint64 sch_id)
+{
+    m_stream << static_cast<quint8>(type) << nsecs << static_cast<quint64>(sch_id);
+}
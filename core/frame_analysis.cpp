@@ -0,0 +1,85 @@
+#include "core/frame_analysis.h"
+
+#include <QtCore/qmath.h>
+
+namespace {
+    thread_local FrameAnalysis::Scope* t_scope = nullptr;
+}
+
+FrameAnalysis::Scope::Scope(uint64 sch_id, anyID client_id, const short* samples, int sample_count)
+    : m_previous(t_scope)
+    , m_sch_id(sch_id)
+    , m_client_id(client_id)
+    , m_samples(samples)
+    , m_sample_count(sample_count)
+{
+    t_scope = this;
+}
+
+FrameAnalysis::Scope::~Scope()
+{
+    t_scope = m_previous;
+}
+
+FrameAnalysis::Result FrameAnalysis::get(const short* samples, int sample_count)
+{
+    auto scope = t_scope;
+    if (!scope || scope->m_samples != samples || scope->m_sample_count != sample_count)
+        return analyze(samples, sample_count);
+
+    if (!scope->m_is_valid)
+    {
+        scope->m_result = analyze(samples, sample_count);
+        scope->m_is_valid = true;
+    }
+    return scope->m_result;
+}
+
+void FrameAnalysis::invalidate(const short* samples)
+{
+    for (auto scope = t_scope; scope; scope = scope->m_previous)
+    {
+        if (scope->m_samples == samples)
+            scope->m_is_valid = false;
+    }
+}
+
+bool FrameAnalysis::current(uint64* sch_id, anyID* client_id)
+{
+    if (!t_scope)
+        return false;
+
+    *sch_id = t_scope->m_sch_id;
+    *client_id = t_scope->m_client_id;
+    return true;
+}
+
+//! Analyze a block in one pass
+/*!
+ * \brief FrameAnalysis::analyze integer only and branch free so it vectorizes
+ * \param samples interleaved samples
+ * \param sample_count frames * channels
+ * \return peak, rms and clip count
+ */
+FrameAnalysis::Result FrameAnalysis::analyze(const short* samples, int sample_count)
+{
+    Result result;
+    if (sample_count <= 0)
+        return result;
+
+    int peak = 0;
+    qint64 sum_squares = 0;
+    int clip_count = 0;
+    for (int i = 0; i < sample_count; ++i)
+    {
+        const int kSample = samples[i];
+        const int kAbs = (kSample < 0) ? -kSample : kSample;
+        peak = (kAbs > peak) ? kAbs : peak;
+        sum_squares += kSample * kSample;
+        clip_count += (kAbs >= 32767);
+    }
+    result.peak = static_cast<short>(qMin(peak, 32767));
+    result.rms = static_cast<float>(qSqrt(static_cast<double>(sum_squares) / sample_count) / 32768.0);
+    result.clip_count = clip_count;
+    return result;
+}
@@ -0,0 +1,118 @@
+#include "core/group_cache.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+#include "core/ts_helpers_qt.h"
+#include "core/ts_logging_qt.h"
+
+namespace {
+
+    // unique ids are base64 and may contain '/'
+    bool GetFilePath(const QString& server_unique_id, QString* result)
+    {
+        QDir dir;
+        if (server_unique_id.isEmpty() || !TSHelpers::GetCreatePluginConfigFolder(dir))
+            return false;
+
+        if (!dir.exists("group_cache") && !dir.mkdir("group_cache"))
+        {
+            TSLogging::Error("(GroupCache) Could not create cache folder.", true);
+            return false;
+        }
+
+        const auto kHash = QCryptographicHash::hash(server_unique_id.toUtf8(), QCryptographicHash::Sha1).toHex();
+        *result = dir.filePath(QString("group_cache/%1.groups").arg(QString::fromLatin1(kHash)));
+        return true;
+    }
+
+    bool ReadGroups(QDataStream& in, QMap<uint64, QString>* groups)
+    {
+        quint32 count;
+        in >> count;
+        for (quint32 i = 0; (i < count) && (in.status() == QDataStream::Ok); ++i)
+        {
+            quint64 group_id;
+            QByteArray name;
+            in >> group_id >> name;
+            groups->insert(group_id, QString::fromUtf8(name));
+        }
+        return (in.status() == QDataStream::Ok);
+    }
+
+    void WriteGroups(QDataStream& out, const QMap<uint64, QString>& groups)
+    {
+        out << static_cast<quint32>(groups.size());
+        for (auto it = groups.constBegin(); it != groups.constEnd(); ++it)
+            out << static_cast<quint64>(it.key()) << it.value().toUtf8();
+    }
+}
+
+namespace GroupCache
+{
+    bool Load(const QString& server_unique_id, QMap<uint64, QString>* server_groups, QMap<uint64, QString>* channel_groups)
+    {
+        QString file_path;
+        if (!GetFilePath(server_unique_id, &file_path))
+            return false;
+
+        QFile file(file_path);
+        if (!file.exists())
+            return false;
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            TS_ERROR(QString("(GroupCache::Load) Could not open %1: %2").arg(file_path).arg(file.errorString()), true);
+            return false;
+        }
+
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_5_0);
+        quint32 magic;
+        quint16 version;
+        in >> magic >> version;
+        if ((magic != kMagic) || (version != kVersion))
+            return false;
+
+        QMap<uint64, QString> server_groups_read;
+        QMap<uint64, QString> channel_groups_read;
+        if (!ReadGroups(in, &server_groups_read) || !ReadGroups(in, &channel_groups_read))
+        {
+            TS_ERROR(QString("(GroupCache::Load) %1 is damaged.").arg(file_path), true);
+            return false;
+        }
+
+        server_groups->swap(server_groups_read);
+        channel_groups->swap(channel_groups_read);
+        return true;
+    }
+
+    bool Save(const QString& server_unique_id, const QMap<uint64, QString>& server_groups, const QMap<uint64, QString>& channel_groups)
+    {
+        QString file_path;
+        if (!GetFilePath(server_unique_id, &file_path))
+            return false;
+
+        QSaveFile file(file_path);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            TS_ERROR(QString("(GroupCache::Save) Could not open %1: %2").arg(file_path).arg(file.errorString()), true);
+            return false;
+        }
+
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << kMagic << kVersion;
+        WriteGroups(out, server_groups);
+        WriteGroups(out, channel_groups);
+        if (!file.commit())
+        {
+            TS_ERROR(QString("(GroupCache::Save) Could not write %1: %2").arg(file_path).arg(file.errorString()), true);
+            return false;
+        }
+        return true;
+    }
+}
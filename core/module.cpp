@@ -72,11 +72,19 @@ void Module::Print(QString message, uint64 serverConnectionHandlerID, LogLevel l
 
 void Module::Log(QString message, uint64 serverConnectionHandlerID, LogLevel logLevel)
 {
-    TSLogging::Log((this->objectName() + ": " + message),serverConnectionHandlerID,logLevel);
-    Print(message, serverConnectionHandlerID, logLevel);
+    // deferred, in async mode the concatenation happens on the log thread
+    if (TSLogging::IsLogged(logLevel))
+        TSLogging::LogFormat(serverConnectionHandlerID, logLevel, "%1: %2", this->objectName(), message);
+
+    Print(message, serverConnectionHandlerID, logLevel);   // has its own switch
+}
+
+void Module::Error(const ErrorLimiter::CallSite& callSite, QString message, uint64 serverConnectionHandlerID, unsigned int error)
+{
+    TSLogging::Error(callSite, (this->objectName() + ": " + message), serverConnectionHandlerID, error);
 }
 
 void Module::Error(QString message, uint64 serverConnectionHandlerID, unsigned int error)
 {
-    TSLogging::Error((this->objectName() + ": " + message), serverConnectionHandlerID, error);
+    Error(ErrorLimiter::CallSite{nullptr, 0}, message, serverConnectionHandlerID, error);
 }
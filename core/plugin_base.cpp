@@ -10,6 +10,10 @@
 #include "core/ts_logging_qt.h"
 #include "core/ts_settings_qt.h"
 #include "core/ts_helpers_qt.h"
+#include "core/ts_identity_qt.h"
+#include "core/ts_channel_tree.h"
+#include "core/ts_client_table.h"
+#include "core/frame_analysis.h"
 
 Plugin_Base::Plugin_Base(const char* plugin_id, QObject *parent)
 	: QObject(parent)
@@ -53,6 +57,14 @@ Talkers& Plugin_Base::talkers()
 	return *m_talkers;
 }
 
+EventRecorder& Plugin_Base::event_recorder()
+{
+	if (!m_event_recorder)
+		m_event_recorder = new EventRecorder(this);
+
+	return *m_event_recorder;
+}
+
 int Plugin_Base::init()
 {
 	TSLogging::Log("init");
@@ -63,25 +75,12 @@ int Plugin_Base::init()
 
 	TSSettings::instance()->Init(TSHelpers::GetConfigPath());
 
-	// load sqlite driver if necessary
-	if (QSqlDatabase::connectionNames().isEmpty())
+	// Summaries of the errors TSLogging::Error suppressed, off the reporting threads
+	if (!m_error_summary_timer)
 	{
-		TSLogging::Log("Loading Database...");
-		QSqlDatabase db;
-
-		db = QSqlDatabase::addDatabase("QSQLITE");
-		db.setDatabaseName(TSHelpers::GetConfigPath() + "settings.db");
-
-		if (db.isValid())
-			TSLogging::Log("Database is valid.");
-		else
-			TSLogging::Log("Database is not valid.");
-
-		if (!db.open())
-		{
-			TSLogging::Error("Error loading settings.db; aborting init", 0, NULL);
-			return 1;
-		}
+		m_error_summary_timer = new QTimer(this);
+		connect(m_error_summary_timer, &QTimer::timeout, this, []() { TSLogging::FlushSuppressedErrors(); });
+		m_error_summary_timer->start(ErrorLimiter::kRefillMs);
 	}
 
 	const auto kDerivedResult = initialize();
@@ -176,6 +175,16 @@ void Plugin_Base::currentServerConnectionChanged(uint64 serverConnectionHandlerI
 
 void Plugin_Base::onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus, unsigned int errorNumber)
 {
+	if (is_recording())
+		m_event_recorder->record_connect_status(serverConnectionHandlerID, newStatus, errorNumber);
+
+	if (newStatus == STATUS_CONNECTION_ESTABLISHED)
+	{
+		TSIdentity::instance()->onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus);
+		TSChannelTree::instance()->onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus);
+		TSClientTable::instance()->onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus);
+	}
+
 	talkers().onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus, errorNumber);
 	if (newStatus == STATUS_CONNECTION_ESTABLISHED)
 	{
@@ -183,24 +192,72 @@ void Plugin_Base::onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, i
 		// Fake client move of myself
 
 		unsigned int error;
-		// Get My Id on this handler
 		anyID myID;
-		if ((error = ts3Functions.getClientID(serverConnectionHandlerID, &myID)) != ERROR_ok)
-			TSLogging::Error("(ts3plugin_onConnectStatusChangeEvent) Error getting my clientID");
+		uint64 channelID;
+		if ((error = TSIdentity::instance()->GetMyId(serverConnectionHandlerID, &myID)) != ERROR_ok)
+			TSLogging::Error("(ts3plugin_onConnectStatusChangeEvent) Error getting my clientID", serverConnectionHandlerID, error);
+		else if ((error = TSIdentity::instance()->GetMyChannel(serverConnectionHandlerID, &channelID)) != ERROR_ok)
+			TSLogging::Error("(ts3plugin_onConnectStatusChangeEvent) Error getting my clients channel id", serverConnectionHandlerID, error);
+		else
 		{
-			// Get My channel on this handler
-			uint64 channelID;
-			if ((error = ts3Functions.getChannelOfClient(serverConnectionHandlerID, myID, &channelID)) != ERROR_ok)
-				TSLogging::Error("(ts3plugin_onConnectStatusChangeEvent) Error getting my clients channel id", serverConnectionHandlerID, error);
-			else
-				onClientMoveEvent(serverConnectionHandlerID, myID, 0, channelID, ENTER_VISIBILITY, "");
+			if (is_recording())
+				m_event_recorder->record_identity(serverConnectionHandlerID, myID, channelID);
+
+			onClientMoveEvent(serverConnectionHandlerID, myID, 0, channelID, ENTER_VISIBILITY, "");
 		}
 	}
 	on_connect_status_changed(serverConnectionHandlerID, newStatus, errorNumber);
+
+	if (newStatus == STATUS_DISCONNECTED)
+	{
+		TSIdentity::instance()->onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus);
+		TSChannelTree::instance()->onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus);
+		TSClientTable::instance()->onConnectStatusChangeEvent(serverConnectionHandlerID, newStatus);
+	}
+}
+
+void Plugin_Base::onNewChannelCreatedEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 channelParentID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier)
+{
+	TSChannelTree::instance()->onNewChannelCreatedEvent(serverConnectionHandlerID, channelID, channelParentID);
+	on_new_channel_created(serverConnectionHandlerID, channelID, channelParentID, invokerID, invokerName, invokerUniqueIdentifier);
+}
+
+void Plugin_Base::onDelChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier)
+{
+	TSChannelTree::instance()->onDelChannelEvent(serverConnectionHandlerID, channelID);
+	on_del_channel(serverConnectionHandlerID, channelID, invokerID, invokerName, invokerUniqueIdentifier);
+}
+
+void Plugin_Base::onChannelMoveEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 newChannelParentID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier)
+{
+	TSChannelTree::instance()->onChannelMoveEvent(serverConnectionHandlerID, channelID, newChannelParentID);
+	on_channel_move(serverConnectionHandlerID, channelID, newChannelParentID, invokerID, invokerName, invokerUniqueIdentifier);
+}
+
+void Plugin_Base::onUpdateChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID)
+{
+	TSChannelTree::instance()->onUpdateChannelEvent(serverConnectionHandlerID, channelID);
+	on_update_channel(serverConnectionHandlerID, channelID);
+}
+
+void Plugin_Base::onUpdateChannelEditedEvent(uint64 serverConnectionHandlerID, uint64 channelID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier)
+{
+	TSChannelTree::instance()->onUpdateChannelEvent(serverConnectionHandlerID, channelID);
+	on_update_channel_edited(serverConnectionHandlerID, channelID, invokerID, invokerName, invokerUniqueIdentifier);
+}
+
+void Plugin_Base::onUpdateClientEvent(uint64 serverConnectionHandlerID, anyID clientID, anyID invokerID, const char* invokerName, const char* invokerUniqueIdentifier)
+{
+	TSClientTable::instance()->onUpdateClientEvent(serverConnectionHandlerID, clientID);
+	on_update_client(serverConnectionHandlerID, clientID, invokerID, invokerName, invokerUniqueIdentifier);
 }
 
 void Plugin_Base::onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, const char * moveMessage)
 {
+	if (is_recording())
+		m_event_recorder->record_client_move(EventTrace::Type::ClientMove, serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
 	const auto kMyId = my_id_move_event(serverConnectionHandlerID, clientID, newChannelID, visibility);
 	if (kMyId)
 		on_client_move(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility, kMyId, moveMessage);
@@ -208,6 +265,10 @@ void Plugin_Base::onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clie
 
 void Plugin_Base::onClientMoveTimeoutEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, const char * timeoutMessage)
 {
+	if (is_recording())
+		m_event_recorder->record_client_move(EventTrace::Type::ClientMoveTimeout, serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
 	const auto kMyId = my_id_move_event(serverConnectionHandlerID, clientID, newChannelID, visibility);
 	if (kMyId)
 		on_client_move_timeout(serverConnectionHandlerID, clientID, newChannelID, kMyId, timeoutMessage);
@@ -215,27 +276,125 @@ void Plugin_Base::onClientMoveTimeoutEvent(uint64 serverConnectionHandlerID, any
 
 void Plugin_Base::onClientMoveMovedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID moverID, const char * moverName, const char * moverUniqueIdentifier, const char * moveMessage)
 {
+	if (is_recording())
+		m_event_recorder->record_client_move(EventTrace::Type::ClientMoveMoved, serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility, moverID);
+
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
 	const auto kMyId = my_id_move_event(serverConnectionHandlerID, clientID, newChannelID, visibility);
 	if (kMyId)
 		on_client_move_moved(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility, kMyId, moverID, moverName, moverUniqueIdentifier, moveMessage);
 }
 
+void Plugin_Base::onClientMoveSubscriptionEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility)
+{
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+	on_client_move_subscription(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+}
+
+void Plugin_Base::onClientKickFromChannelEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage)
+{
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+	TSIdentity::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, newChannelID);
+	on_client_kick_from_channel(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility, kickerID, kickerName, kickerUniqueIdentifier, kickMessage);
+}
+
+void Plugin_Base::onClientKickFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, const char* kickMessage)
+{
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+	TSIdentity::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, newChannelID);
+	on_client_kick_from_server(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility, kickerID, kickerName, kickerUniqueIdentifier, kickMessage);
+}
+
+void Plugin_Base::onClientBanFromServerEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility, anyID kickerID, const char* kickerName, const char* kickerUniqueIdentifier, uint64 time, const char* kickMessage)
+{
+	TSClientTable::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility);
+	TSIdentity::instance()->onClientMoveEvent(serverConnectionHandlerID, clientID, newChannelID);
+	on_client_ban_from_server(serverConnectionHandlerID, clientID, oldChannelID, newChannelID, visibility, kickerID, kickerName, kickerUniqueIdentifier, time, kickMessage);
+}
+
+void Plugin_Base::onServerUpdatedEvent(uint64 serverConnectionHandlerID)
+{
+	on_server_updated(serverConnectionHandlerID);
+}
+
 void Plugin_Base::onTalkStatusChangeEvent(uint64 serverConnectionHandlerID, int status, int isReceivedWhisper, anyID clientID)
 {
+	if (is_recording())
+		m_event_recorder->record_talk_status(serverConnectionHandlerID, status, isReceivedWhisper, clientID);
+
 	const auto kIsMe = talkers().onTalkStatusChangeEvent(serverConnectionHandlerID, status, isReceivedWhisper, clientID);
 	on_talk_status_changed(serverConnectionHandlerID, status, isReceivedWhisper, clientID, kIsMe);
 }
 
 void Plugin_Base::onEditPlaybackVoiceDataEvent(uint64 serverConnectionHandlerID, anyID clientID, short * samples, int sampleCount, int channels)
 {
+	if (is_recording())
+		m_event_recorder->record_voice(EventTrace::Type::PlaybackPreProcess, serverConnectionHandlerID, clientID, samples, sampleCount, channels);
+
+	FrameAnalysis::Scope analysis_scope(serverConnectionHandlerID, clientID, samples, sampleCount * channels);
 	on_playback_pre_process(serverConnectionHandlerID, clientID, samples, sampleCount, channels);
 }
 
 void Plugin_Base::onEditPostProcessVoiceDataEvent(uint64 serverConnectionHandlerID, anyID clientID, short* samples, int sampleCount, int channels, const unsigned int* channelSpeakerArray, unsigned int* channelFillMask)
 {
+	if (is_recording())
+		m_event_recorder->record_voice(EventTrace::Type::PlaybackPostProcess, serverConnectionHandlerID, clientID, samples, sampleCount, channels);
+
+	FrameAnalysis::Scope analysis_scope(serverConnectionHandlerID, clientID, samples, sampleCount * channels);
 	on_playback_post_process(serverConnectionHandlerID, clientID, samples, sampleCount, channels, channelSpeakerArray, channelFillMask);
 }
 
+void Plugin_Base::onServerGroupListEvent(uint64 serverConnectionHandlerID, uint64 serverGroupID, const char* name, int type, int iconID, int saveDB)
+{
+	if (is_recording())
+		m_event_recorder->record_group_list(EventTrace::Type::ServerGroupList, serverConnectionHandlerID, serverGroupID, name, type);
+
+	on_server_group_list(serverConnectionHandlerID, serverGroupID, name, type, iconID, saveDB);
+}
+
+void Plugin_Base::onServerGroupListFinishedEvent(uint64 serverConnectionHandlerID)
+{
+	if (is_recording())
+		m_event_recorder->record_group_list_finished(EventTrace::Type::ServerGroupListFinished, serverConnectionHandlerID);
+
+	on_server_group_list_finished(serverConnectionHandlerID);
+}
+
+void Plugin_Base::onChannelGroupListEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, const char* name, int type, int iconID, int saveDB)
+{
+	if (is_recording())
+		m_event_recorder->record_group_list(EventTrace::Type::ChannelGroupList, serverConnectionHandlerID, channelGroupID, name, type);
+
+	on_channel_group_list(serverConnectionHandlerID, channelGroupID, name, type, iconID, saveDB);
+}
+
+void Plugin_Base::onChannelGroupListFinishedEvent(uint64 serverConnectionHandlerID)
+{
+	if (is_recording())
+		m_event_recorder->record_group_list_finished(EventTrace::Type::ChannelGroupListFinished, serverConnectionHandlerID);
+
+	on_channel_group_list_finished(serverConnectionHandlerID);
+}
+
+void Plugin_Base::onClientChannelGroupChangedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, uint64 channelID, anyID clientID, anyID invokerClientID, const char* invokerName, const char* invokerUniqueIdentity)
+{
+	TSIdentity::instance()->onClientChannelGroupChangedEvent(serverConnectionHandlerID, channelGroupID, clientID);
+	TSClientTable::instance()->onClientChannelGroupChangedEvent(serverConnectionHandlerID, channelGroupID, clientID);
+	on_client_channel_group_changed(serverConnectionHandlerID, channelGroupID, channelID, clientID, invokerClientID, invokerName, invokerUniqueIdentity);
+}
+
+void Plugin_Base::onServerGroupClientAddedEvent(uint64 serverConnectionHandlerID, anyID clientID, const char* clientName, const char* clientUniqueIdentity, uint64 serverGroupID, anyID invokerClientID, const char* invokerName, const char* invokerUniqueIdentity)
+{
+	TSClientTable::instance()->onServerGroupClientAddedEvent(serverConnectionHandlerID, clientID, serverGroupID);
+	on_server_group_client_added(serverConnectionHandlerID, clientID, clientName, clientUniqueIdentity, serverGroupID, invokerClientID, invokerName, invokerUniqueIdentity);
+}
+
+void Plugin_Base::onServerGroupClientDeletedEvent(uint64 serverConnectionHandlerID, anyID clientID, const char* clientName, const char* clientUniqueIdentity, uint64 serverGroupID, anyID invokerClientID, const char* invokerName, const char* invokerUniqueIdentity)
+{
+	TSClientTable::instance()->onServerGroupClientDeletedEvent(serverConnectionHandlerID, clientID, serverGroupID);
+	on_server_group_client_deleted(serverConnectionHandlerID, clientID, clientName, clientUniqueIdentity, serverGroupID, invokerClientID, invokerName, invokerUniqueIdentity);
+}
+
 void Plugin_Base::onMenuItemEvent(uint64 serverConnectionHandlerID, PluginMenuType type, int menuItemID, uint64 selectedItemID)
 {
 	context_menu().onMenuItemEvent(serverConnectionHandlerID, type, menuItemID, selectedItemID);
@@ -263,10 +422,12 @@ void Plugin_Base::onMenuItemEvent(uint64 serverConnectionHandlerID, PluginMenuTy
 
 anyID Plugin_Base::my_id_move_event(uint64 sch_id, anyID client_id, uint64 new_channel_id, int visibility)
 {
+	TSIdentity::instance()->onClientMoveEvent(sch_id, client_id, new_channel_id);
+
 	unsigned int error;
 	if (new_channel_id == 0)  // When we disconnect, we get moved to chan 0 before the connection event
-	{                       // However, we aren't able to get our own id etc. anymore via the API for comparison
-		int con_status;     // Therefor, unless we cache our ids for no other benefit, this is a workaround by filtering those out
+	{                       // Handlers would query the API for a connection that is already gone,
+		int con_status;     // so those are filtered out; the disconnect itself arrives via on_connect_status_change
 		if ((error = ts3Functions.getConnectionStatus(sch_id, &con_status)) != ERROR_ok)
 		{
 			TSLogging::Error("(filter_move_event)", sch_id, error);
@@ -280,7 +441,7 @@ anyID Plugin_Base::my_id_move_event(uint64 sch_id, anyID client_id, uint64 new_c
 
 	// Get My Id on this handler
 	anyID my_id;
-	if ((error = ts3Functions.getClientID(sch_id, &my_id)) != ERROR_ok)
+	if ((error = TSIdentity::instance()->GetMyId(sch_id, &my_id)) != ERROR_ok)
 	{
 		TSLogging::Error("(ts3plugin_onClientMoveEvent)", sch_id, error);
 		return 0;
@@ -0,0 +1,215 @@
+#include "core/talk_stats.h"
+
+#include <algorithm>
+
+const std::array<int, TalkStats::WINDOW_COUNT> TalkStats::kWindowBuckets = {{ 4, 20, 240 }};
+
+TalkStats::TalkStats()
+{
+    m_clock.start();
+}
+
+qint64 TalkStats::window_length_ms(Window window)
+{
+    return static_cast<qint64>(kWindowBuckets[window]) * kBucketMs;
+}
+
+void TalkStats::onTalkStatusChange(uint64 sch_id, anyID client_id, bool is_talking)
+{
+    const auto kNow = now_ms();
+    auto& server = m_servers[sch_id];
+    if (!server)
+        server.reset(new ServerStats);
+
+    auto& entry = (*server)[client_id];
+    if (is_talking)
+    {
+        if (entry.burst_start_ms >= 0)
+            return;
+
+        ++entry.talk_starts;
+        entry.burst_start_ms = kNow;
+        entry.accounted_ms = kNow;
+        advance(entry, kNow / kBucketMs);
+    }
+    else
+    {
+        if (entry.burst_start_ms < 0)
+            return;
+
+        sync(entry, kNow);
+        entry.total_ms += static_cast<quint64>(kNow - entry.burst_start_ms);
+        entry.burst_start_ms = -1;
+    }
+}
+
+void TalkStats::clear(uint64 sch_id)
+{
+    m_servers.erase(sch_id);
+}
+
+bool TalkStats::stats(uint64 sch_id, anyID client_id, Stats* result)
+{
+    auto entry = find(sch_id, client_id);
+    if (!entry)
+        return false;
+
+    const auto kNow = now_ms();
+    sync(*entry, kNow);
+    *result = to_stats(client_id, *entry, kNow);
+    return true;
+}
+
+double TalkStats::talk_share(uint64 sch_id, anyID client_id, Window window)
+{
+    Stats stats;
+    if (!this->stats(sch_id, client_id, &stats))
+        return 0.0;
+
+    return static_cast<double>(stats.window_ms[window]) / window_length_ms(window);
+}
+
+//! Rank the clients of a server by talk time in a window
+/*!
+ * \brief TalkStats::top_talkers brings every entry up to date and selects with nth_element, O(N + K log K)
+ * \param sch_id the server connection
+ * \param window the rolling window
+ * \param k maximum number of results
+ * \return up to k clients with talk time in the window, most first
+ */
+std::vector<TalkStats::Stats> TalkStats::top_talkers(uint64 sch_id, Window window, int k)
+{
+    std::vector<Stats> result;
+    auto it = m_servers.find(sch_id);
+    if (it == m_servers.end() || k <= 0)
+        return result;
+
+    const auto kNow = now_ms();
+    result.reserve(it->second->size());
+    for (auto& pair : *it->second)
+    {
+        sync(pair.second, kNow);
+        if (pair.second.window_ms[window] > 0)
+            result.push_back(to_stats(pair.first, pair.second, kNow));
+    }
+
+    const auto kMore = [window](const Stats& a, const Stats& b)
+    {
+        return (a.window_ms[window] != b.window_ms[window]) ? (a.window_ms[window] > b.window_ms[window]) : (a.client_id < b.client_id);
+    };
+    if (result.size() > static_cast<size_t>(k))
+    {
+        std::nth_element(result.begin(), result.begin() + k, result.end(), kMore);
+        result.resize(k);
+    }
+    std::sort(result.begin(), result.end(), kMore);
+    return result;
+}
+
+std::vector<TalkStats::Stats> TalkStats::longest_bursts(uint64 sch_id, int k)
+{
+    std::vector<Stats> result;
+    auto it = m_servers.find(sch_id);
+    if (it == m_servers.end() || k <= 0)
+        return result;
+
+    const auto kNow = now_ms();
+    for (auto& pair : *it->second)
+    {
+        if (pair.second.burst_start_ms < 0)
+            continue;
+
+        sync(pair.second, kNow);
+        result.push_back(to_stats(pair.first, pair.second, kNow));
+    }
+
+    const auto kLonger = [](const Stats& a, const Stats& b)
+    {
+        return (a.current_burst_ms != b.current_burst_ms) ? (a.current_burst_ms > b.current_burst_ms) : (a.client_id < b.client_id);
+    };
+    if (result.size() > static_cast<size_t>(k))
+    {
+        std::nth_element(result.begin(), result.begin() + k, result.end(), kLonger);
+        result.resize(k);
+    }
+    std::sort(result.begin(), result.end(), kLonger);
+    return result;
+}
+
+// Moves the ring forward to bucket, expiring what falls out of each window
+void TalkStats::advance(Entry& entry, qint64 bucket)
+{
+    if (bucket <= entry.head)
+        return;
+
+    if (entry.head < 0 || bucket - entry.head >= kBucketCount)
+    {
+        entry.buckets.fill(0);
+        entry.window_ms.fill(0);
+        entry.head = bucket;
+        return;
+    }
+
+    while (entry.head < bucket)
+    {
+        ++entry.head;
+        for (int w = 0; w < WINDOW_COUNT; ++w)
+            entry.window_ms[w] -= entry.buckets[slot(entry.head - kWindowBuckets[w])];
+
+        entry.buckets[slot(entry.head)] = 0;
+    }
+}
+
+// Adds the talk time [from_ms, to_ms) to the buckets it spans
+void TalkStats::account(Entry& entry, qint64 from_ms, qint64 to_ms)
+{
+    while (from_ms < to_ms)
+    {
+        const auto kBucket = from_ms / kBucketMs;
+        const auto kEnd = qMin(to_ms, (kBucket + 1) * kBucketMs);
+        advance(entry, kBucket);
+        const auto kMs = static_cast<quint16>(kEnd - from_ms);
+        entry.buckets[slot(kBucket)] += kMs;
+        for (auto& window_ms : entry.window_ms)
+            window_ms += kMs;
+
+        from_ms = kEnd;
+    }
+}
+
+// Accounts an ongoing burst up to now and expires old buckets
+void TalkStats::sync(Entry& entry, qint64 now_ms)
+{
+    if (entry.burst_start_ms >= 0)
+    {
+        // bursts longer than the ring only need their last hour
+        account(entry, qMax(entry.accounted_ms, now_ms - window_length_ms(WINDOW_60MIN)), now_ms);
+        entry.accounted_ms = now_ms;
+    }
+    advance(entry, now_ms / kBucketMs);
+}
+
+TalkStats::Stats TalkStats::to_stats(anyID client_id, const Entry& entry, qint64 now_ms)
+{
+    Stats stats;
+    stats.client_id = client_id;
+    stats.talk_starts = entry.talk_starts;
+    stats.total_ms = entry.total_ms;
+    if (entry.burst_start_ms >= 0)
+    {
+        stats.current_burst_ms = now_ms - entry.burst_start_ms;
+        stats.total_ms += static_cast<quint64>(stats.current_burst_ms);
+    }
+    stats.window_ms = entry.window_ms;
+    return stats;
+}
+
+TalkStats::Entry* TalkStats::find(uint64 sch_id, anyID client_id)
+{
+    auto server = m_servers.find(sch_id);
+    if (server == m_servers.end())
+        return nullptr;
+
+    auto it = server->second->find(client_id);
+    return (it == server->second->end()) ? nullptr : &it->second;
+}
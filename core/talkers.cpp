@@ -1,18 +1,88 @@
 #include "core/talkers.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "teamspeak/public_errors.h"
 #include "teamspeak/public_errors_rare.h"
 #include "teamspeak/public_rare_definitions.h"
 #include "ts3_functions.h"
 
 #include "core/ts_logging_qt.h"
+#include "core/ts_identity_qt.h"
 
 #include "plugin.h"
 
+const TalkersSnapshot::Server* TalkersSnapshot::server(uint64 sch_id) const
+{
+    auto it = std::lower_bound(servers.cbegin(), servers.cend(), sch_id, [](const Server& server, uint64 id) { return server.sch_id < id; });
+    return (it != servers.cend() && it->sch_id == sch_id) ? &(*it) : nullptr;
+}
+
+int TalkersSnapshot::talker_count(uint64 sch_id) const
+{
+    const auto kServer = server(sch_id);
+    return kServer ? static_cast<int>(kServer->talkers.size()) : 0;
+}
+
+int TalkersSnapshot::whisperer_count(uint64 sch_id) const
+{
+    const auto kServer = server(sch_id);
+    return kServer ? static_cast<int>(kServer->whisperers.size()) : 0;
+}
+
+bool TalkersSnapshot::is_talking(uint64 sch_id, anyID client_id) const
+{
+    const auto kServer = server(sch_id);
+    return kServer && std::binary_search(kServer->talkers.cbegin(), kServer->talkers.cend(), client_id);
+}
+
+bool TalkersSnapshot::is_whispering(uint64 sch_id, anyID client_id) const
+{
+    const auto kServer = server(sch_id);
+    return kServer && std::binary_search(kServer->whisperers.cbegin(), kServer->whisperers.cend(), client_id);
+}
+
+Talkers::SnapshotReader::SnapshotReader(const Talkers& talkers)
+{
+    // pin, then make sure the buffer is still current; a publish may have switched away from it in between
+    for (;;)
+    {
+        const auto kIndex = talkers.m_current.load();
+        m_readers = &talkers.m_readers[kIndex];
+        m_readers->fetch_add(1);
+        if (talkers.m_current.load() == kIndex)
+        {
+            m_snapshot = &talkers.m_snapshots[kIndex];
+            return;
+        }
+        m_readers->fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+Talkers::SnapshotReader::~SnapshotReader()
+{
+    m_readers->fetch_sub(1, std::memory_order_release);
+}
+
 Talkers::Talkers(QObject* parent)
 	: QObject(parent)
+{
+    m_readers[0].store(0, std::memory_order_relaxed);
+    m_readers[1].store(0, std::memory_order_relaxed);
+}
+
+Talkers::~Talkers()
 {}
 
+//! Refresh the talkers of a server from the client
+/*!
+ * \brief Talkers::RefreshTalkers builds the talking state in one pass over the client list,
+ * diffs it against the current state and delivers the differences as a single batch
+ * to the registered TalkInterfaces and the TalkStatusChanges signal
+ * \param serverConnectionHandlerID the server connection
+ * \return error code; the current state is left untouched on error
+ */
 unsigned int Talkers::RefreshTalkers(uint64 serverConnectionHandlerID)
 {
     unsigned int error = ERROR_ok;
@@ -24,44 +94,105 @@ unsigned int Talkers::RefreshTalkers(uint64 serverConnectionHandlerID)
         return ERROR_ok;
 
     anyID myID;
-    if ((error = ts3Functions.getClientID(serverConnectionHandlerID, &myID)) != ERROR_ok)
+    if ((error = TSIdentity::instance()->GetMyId(serverConnectionHandlerID, &myID)) != ERROR_ok)
         return error;
 
     int talking;
     if ((error = ts3Functions.getClientSelfVariableAsInt(serverConnectionHandlerID, CLIENT_FLAG_TALKING, &talking)) != ERROR_ok)
         return error;
 
-    if (talking == STATUS_TALKING)
-    {
-        int isWhispering;
-        if ((error = ts3Functions.isWhispering(serverConnectionHandlerID, myID, &isWhispering)) != ERROR_ok)
-            return error;
-
-        onTalkStatusChangeEvent(serverConnectionHandlerID, STATUS_TALKING, isWhispering, myID);
-    }
+    const bool kIsMeTalking = (talking == STATUS_TALKING);
+    int isMeWhispering = 0;
+    if (kIsMeTalking && ((error = ts3Functions.isWhispering(serverConnectionHandlerID, myID, &isMeWhispering)) != ERROR_ok))
+        return error;
 
     //Get all visible clients
     anyID *clientList;
     if ((error = ts3Functions.getClientList(serverConnectionHandlerID, &clientList)) != ERROR_ok)
         return error;
 
+    std::unique_ptr<ServerTalkers> fresh(new ServerTalkers);
     for (int i=0; clientList[i]; ++i)
     {
         const auto kClientId = clientList[i];
-        if (ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, kClientId, CLIENT_FLAG_TALKING, &talking) == ERROR_ok)
-        {
-            if (talking == STATUS_TALKING)
-            {
-                int isWhispering;
-                if ((error = ts3Functions.isWhispering(serverConnectionHandlerID, kClientId, &isWhispering)) != ERROR_ok)
-                    continue;
+        if (kClientId == myID)
+            continue;
 
-                onTalkStatusChangeEvent(serverConnectionHandlerID, STATUS_TALKING, isWhispering, kClientId);
-            }
-        }
+        if ((ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, kClientId, CLIENT_FLAG_TALKING, &talking) != ERROR_ok) || (talking != STATUS_TALKING))
+            continue;
+
+        int isWhispering;
+        if (ts3Functions.isWhispering(serverConnectionHandlerID, kClientId, &isWhispering) != ERROR_ok)
+            continue;
+
+        if (isWhispering)
+            fresh->whisperers.insert(kClientId);
+        else
+            fresh->talkers.insert(kClientId);
     }
     ts3Functions.freeMemory(clientList);
-    return error;
+
+    auto& current = m_servers[serverConnectionHandlerID];
+    if (!current)
+        current.reset(new ServerTalkers);
+
+    QVector<TalkStatusChange> changes;
+    current->whisperers.for_each([&](anyID client_id)
+    {
+        if (!fresh->whisperers.contains(client_id))
+            changes.append({client_id, STATUS_NOT_TALKING, true, false});
+    });
+    current->talkers.for_each([&](anyID client_id)
+    {
+        if (!fresh->talkers.contains(client_id))
+            changes.append({client_id, STATUS_NOT_TALKING, false, false});
+    });
+    const bool kWasMeTalking = (m_meTalkingScHandler == serverConnectionHandlerID);
+    if (kWasMeTalking && (!kIsMeTalking || (m_meTalkingIsWhisper != (isMeWhispering != 0))))
+        changes.append({myID, STATUS_NOT_TALKING, m_meTalkingIsWhisper, true});
+
+    fresh->talkers.for_each([&](anyID client_id)
+    {
+        if (!current->talkers.contains(client_id))
+            changes.append({client_id, STATUS_TALKING, false, false});
+    });
+    fresh->whisperers.for_each([&](anyID client_id)
+    {
+        if (!current->whisperers.contains(client_id))
+            changes.append({client_id, STATUS_TALKING, true, false});
+    });
+    if (kIsMeTalking && (!kWasMeTalking || (m_meTalkingIsWhisper != (isMeWhispering != 0))))
+        changes.append({myID, STATUS_TALKING, isMeWhispering != 0, true});
+
+    if (fresh->talkers.isEmpty() && fresh->whisperers.isEmpty())
+        m_servers.erase(serverConnectionHandlerID);
+    else
+        current.swap(fresh);
+
+    if (changes.isEmpty())
+        return ERROR_ok;
+
+    if (kIsMeTalking)
+    {
+        m_meTalkingScHandler = serverConnectionHandlerID;
+        m_meTalkingIsWhisper = (isMeWhispering != 0);
+    }
+    else if (kWasMeTalking)
+        m_meTalkingScHandler = 0;
+
+    m_is_maps_dirty = true;
+    publish();
+
+    for (const auto& change : changes)
+        m_talk_stats.onTalkStatusChange(serverConnectionHandlerID, change.client_id, change.status == STATUS_TALKING);
+
+    for (const auto& p : m_talk_interfaces)
+    {
+        if (auto iTalk = qobject_cast<TalkInterface*>(p.data()))
+            iTalk->onTalkStatusChanges(serverConnectionHandlerID, changes);
+    }
+    emit TalkStatusChanges(serverConnectionHandlerID, changes);
+    return ERROR_ok;
 }
 
 unsigned int Talkers::RefreshAllTalkers()  // I assume getClientVariableAsInt only returns whisperer to me as talking and isWhispering == isWhisperingMe
@@ -89,18 +220,25 @@ void Talkers::DumpTalkStatusChanges(QObject *p, int status)
         return;
     }
 
-    for (auto it = TalkerMap.cbegin(); it != TalkerMap.cend(); ++it)
-        iTalk->onTalkStatusChanged(it.key(), status, false, it.value(), false);
-
-    for (auto it = WhisperMap.cbegin(); it != WhisperMap.cend(); ++it)
-        iTalk->onTalkStatusChanged(it.key(), status, true, it.value(), false);
+    for (const auto& server : m_servers)
+    {
+        const auto kServerConnectionHandlerID = server.first;
+        server.second->talkers.for_each([&](anyID client_id)
+        {
+            iTalk->onTalkStatusChanged(kServerConnectionHandlerID, status, false, client_id, false);
+        });
+        server.second->whisperers.for_each([&](anyID client_id)
+        {
+            iTalk->onTalkStatusChanged(kServerConnectionHandlerID, status, true, client_id, false);
+        });
+    }
 
     if (m_meTalkingScHandler != 0)
     {
         unsigned int error;
         // Get My Id on this handler
         anyID myID;
-        if ((error = ts3Functions.getClientID(m_meTalkingScHandler,&myID)) != ERROR_ok)
+        if ((error = TSIdentity::instance()->GetMyId(m_meTalkingScHandler, &myID)) != ERROR_ok)
         {
             TSLogging::Error("DumpTalkStatusChanges", m_meTalkingScHandler, error);
             return;
@@ -109,13 +247,29 @@ void Talkers::DumpTalkStatusChanges(QObject *p, int status)
     }
 }
 
+void Talkers::RegisterTalkInterface(QObject* p)
+{
+    if (!qobject_cast<TalkInterface*>(p))
+    {
+        TSLogging::Error("(Talkers) (RegisterTalkInterface) Pointer doesn't implement TalkInterface");
+        return;
+    }
+    if (!m_talk_interfaces.contains(p))
+        m_talk_interfaces.append(p);
+}
+
+void Talkers::UnregisterTalkInterface(QObject* p)
+{
+    m_talk_interfaces.removeAll(p);
+}
+
 bool Talkers::onTalkStatusChangeEvent(uint64 serverConnectionHandlerID, int status, int isReceivedWhisper, anyID clientID)
 {
     unsigned int error;
 
     // Get My Id on this handler
     anyID myID;
-    if ((error = ts3Functions.getClientID(serverConnectionHandlerID, &myID)) != ERROR_ok)
+    if ((error = TSIdentity::instance()->GetMyId(serverConnectionHandlerID, &myID)) != ERROR_ok)
     {
         TSLogging::Error("onTalkStatusChangeEvent", serverConnectionHandlerID, error);
         return false;
@@ -129,28 +283,38 @@ bool Talkers::onTalkStatusChangeEvent(uint64 serverConnectionHandlerID, int stat
         else
             m_meTalkingScHandler = 0;
 
+        m_talk_stats.onTalkStatusChange(serverConnectionHandlerID, clientID, status == STATUS_TALKING);
+        publish();
         return true;
     }
 
     if (status == STATUS_TALKING)
     {
-        if (isReceivedWhisper)
-        {
-            if (!WhisperMap.contains(serverConnectionHandlerID,clientID))   // pure safety measurement
-                WhisperMap.insert(serverConnectionHandlerID,clientID);
-        }
-        else
+        auto& server = m_servers[serverConnectionHandlerID];
+        if (!server)
+            server.reset(new ServerTalkers);
+
+        if (isReceivedWhisper ? server->whisperers.insert(clientID) : server->talkers.insert(clientID))
         {
-            if (!TalkerMap.contains(serverConnectionHandlerID,clientID))
-                TalkerMap.insert(serverConnectionHandlerID,clientID);
+            m_talk_stats.onTalkStatusChange(serverConnectionHandlerID, clientID, true);
+            m_is_maps_dirty = true;
+            publish();
         }
     }
     else if (status == STATUS_NOT_TALKING)
     {
-        if (isReceivedWhisper)
-            WhisperMap.remove(serverConnectionHandlerID,clientID);
-        else
-            TalkerMap.remove(serverConnectionHandlerID,clientID);
+        auto it = m_servers.find(serverConnectionHandlerID);
+        if (it != m_servers.end())
+        {
+            if (isReceivedWhisper ? it->second->whisperers.remove(clientID) : it->second->talkers.remove(clientID))
+            {
+                if (!it->second->talkers.contains(clientID) && !it->second->whisperers.contains(clientID))
+                    m_talk_stats.onTalkStatusChange(serverConnectionHandlerID, clientID, false);
+
+                m_is_maps_dirty = true;
+                publish();
+            }
+        }
     }
 
     return false;
@@ -160,31 +324,82 @@ void Talkers::onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int n
 {
     if (newStatus == STATUS_DISCONNECTED)
     {
-        if (WhisperMap.contains(serverConnectionHandlerID))
+        auto it = m_servers.find(serverConnectionHandlerID);
+        if (it != m_servers.end())
         {
-            for (const auto& value : WhisperMap.values(serverConnectionHandlerID))
-                ts3plugin_onTalkStatusChangeEvent(serverConnectionHandlerID, STATUS_NOT_TALKING, 0, value);
-        }
+            // the notifications call back into us, so take copies first
+            const auto kWhisperers = it->second->whisperers.values();
+            for (const auto& value : kWhisperers)
+                ts3plugin_onTalkStatusChangeEvent(serverConnectionHandlerID, STATUS_NOT_TALKING, 1, value);
 
-        if (TalkerMap.contains(serverConnectionHandlerID))
-        {
-            for (const auto& value : TalkerMap.values(serverConnectionHandlerID))
+            const auto kTalkers = it->second->talkers.values();
+            for (const auto& value : kTalkers)
                 ts3plugin_onTalkStatusChangeEvent(serverConnectionHandlerID, STATUS_NOT_TALKING, 0, value);
+
+            m_servers.erase(serverConnectionHandlerID);
+            m_is_maps_dirty = true;
+            publish();
         }
+        m_talk_stats.clear(serverConnectionHandlerID);
     }
     emit ConnectStatusChanged(serverConnectionHandlerID, newStatus, errorNumber);
 }
 
 const QMultiMap<uint64, anyID>& Talkers::GetTalkerMap() const
 {
+    update_maps();
     return TalkerMap;
 }
 
 const QMultiMap<uint64, anyID>& Talkers::GetWhisperMap() const
 {
+    update_maps();
     return WhisperMap;
 }
 
+void Talkers::update_maps() const
+{
+    if (!m_is_maps_dirty)
+        return;
+
+    TalkerMap.clear();
+    WhisperMap.clear();
+    for (const auto& server : m_servers)
+    {
+        const auto kServerConnectionHandlerID = server.first;
+        server.second->talkers.for_each([&](anyID client_id) { TalkerMap.insert(kServerConnectionHandlerID, client_id); });
+        server.second->whisperers.for_each([&](anyID client_id) { WhisperMap.insert(kServerConnectionHandlerID, client_id); });
+    }
+    m_is_maps_dirty = false;
+}
+
+void Talkers::publish()
+{
+    const auto kCurrent = m_current.load(std::memory_order_relaxed);
+    const auto kNext = 1 - kCurrent;
+    // readers that pinned kNext before the last publish switched away from it; they're inside a callback
+    while (m_readers[kNext].load() > 0)
+        std::this_thread::yield();
+
+    auto& snapshot = m_snapshots[kNext];
+    snapshot.servers.resize(m_servers.size());
+    auto entry = snapshot.servers.begin();
+    for (const auto& server : m_servers)
+    {
+        entry->sch_id = server.first;
+        entry->talkers.clear();
+        server.second->talkers.for_each([entry](anyID client_id) { entry->talkers.push_back(client_id); });
+        entry->whisperers.clear();
+        server.second->whisperers.for_each([entry](anyID client_id) { entry->whisperers.push_back(client_id); });
+        ++entry;
+    }
+    snapshot.me_talking_sch_id = m_meTalkingScHandler;
+    snapshot.is_me_whispering = (m_meTalkingScHandler != 0) && m_meTalkingIsWhisper;
+    snapshot.generation = m_snapshots[kCurrent].generation + 1;
+
+    m_current.store(kNext);
+}
+
 uint64 Talkers::isMeTalking() const
 {
     return m_meTalkingScHandler;
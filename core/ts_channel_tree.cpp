@@ -0,0 +1,332 @@
+#include "core/ts_channel_tree.h"
+
+#include "teamspeak/public_errors.h"
+#include "teamspeak/public_rare_definitions.h"
+#include "ts3_functions.h"
+#include "plugin.h"
+
+#include "core/ts_logging_qt.h"
+
+TSChannelTree* TSChannelTree::m_Instance = 0;
+
+const QString TSChannelTree::kPathDelimiter = "__CH_DELIM__";
+
+void TSChannelTree::onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus)
+{
+    if (newStatus == STATUS_CONNECTION_ESTABLISHED)
+    {
+        unsigned int error;
+        if ((error = build(serverConnectionHandlerID)) != ERROR_ok)
+            TSLogging::Error("(TSChannelTree) Error building channel tree", serverConnectionHandlerID, error);
+    }
+    else if (newStatus == STATUS_DISCONNECTED)
+        m_servers.erase(serverConnectionHandlerID);
+}
+
+void TSChannelTree::onNewChannelCreatedEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 channelParentID)
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    if (it == m_servers.end())
+        return;
+
+    auto& server = *it->second;
+    Channel channel;
+    unsigned int error;
+    if ((error = fetch(serverConnectionHandlerID, channelID, &channel)) != ERROR_ok)
+    {
+        TSLogging::Error("(TSChannelTree::onNewChannelCreatedEvent)", serverConnectionHandlerID, error);
+        m_servers.erase(it);    // rather no cache than a wrong one
+        return;
+    }
+    if (server.channels.contains(channelID))
+        unlink(server, channelID);
+
+    server.channels.insert(channelID, channel);
+    link(server, channelID, channelParentID);
+    server.is_paths_dirty = true;
+}
+
+void TSChannelTree::onDelChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID)
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    if (it == m_servers.end())
+        return;
+
+    remove(*it->second, channelID);
+    it->second->is_paths_dirty = true;
+}
+
+void TSChannelTree::onChannelMoveEvent(uint64 serverConnectionHandlerID, uint64 channelID, uint64 newChannelParentID)
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    if (it == m_servers.end())
+        return;
+
+    auto& server = *it->second;
+    if (!server.channels.contains(channelID))
+        return;
+
+    unlink(server, channelID);
+    link(server, channelID, newChannelParentID);
+    onUpdateChannelEvent(serverConnectionHandlerID, channelID);   // order
+    server.is_paths_dirty = true;
+}
+
+void TSChannelTree::onUpdateChannelEvent(uint64 serverConnectionHandlerID, uint64 channelID)
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    if (it == m_servers.end())
+        return;
+
+    auto& server = *it->second;
+    auto channel = server.channels.find(channelID);
+    if (channel == server.channels.end())
+        return;
+
+    Channel fetched;
+    if (fetch(serverConnectionHandlerID, channelID, &fetched) != ERROR_ok)
+        return;
+
+    channel->order = fetched.order;
+    if (channel->name != fetched.name)
+    {
+        channel->name = fetched.name;
+        server.is_paths_dirty = true;
+    }
+}
+
+bool TSChannelTree::contains(uint64 serverConnectionHandlerID) const
+{
+    return find(serverConnectionHandlerID) != nullptr;
+}
+
+unsigned int TSChannelTree::GetParentChannel(uint64 serverConnectionHandlerID, uint64 channelID, uint64* result) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return ERROR_not_connected;
+
+    auto it = server->channels.constFind(channelID);
+    if (it == server->channels.constEnd())
+        return ERROR_channel_invalid_id;
+
+    *result = it->parent_id;
+    return ERROR_ok;
+}
+
+unsigned int TSChannelTree::GetSubChannels(uint64 serverConnectionHandlerID, uint64 channelID, QVector<uint64>* result) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return ERROR_not_connected;
+
+    if (channelID == 0)
+    {
+        *result += server->roots;
+        return ERROR_ok;
+    }
+
+    auto it = server->channels.constFind(channelID);
+    if (it == server->channels.constEnd())
+        return ERROR_channel_invalid_id;
+
+    *result += it->children;
+    return ERROR_ok;
+}
+
+unsigned int TSChannelTree::GetChannelName(uint64 serverConnectionHandlerID, uint64 channelID, QString* result) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return ERROR_not_connected;
+
+    auto it = server->channels.constFind(channelID);
+    if (it == server->channels.constEnd())
+        return ERROR_channel_invalid_id;
+
+    *result = it->name;
+    return ERROR_ok;
+}
+
+unsigned int TSChannelTree::GetChannelOrder(uint64 serverConnectionHandlerID, uint64 channelID, uint64* result) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return ERROR_not_connected;
+
+    auto it = server->channels.constFind(channelID);
+    if (it == server->channels.constEnd())
+        return ERROR_channel_invalid_id;
+
+    *result = it->order;
+    return ERROR_ok;
+}
+
+//! Path of a channel, O(depth)
+/*!
+ * \brief TSChannelTree::GetChannelPath names from the root down, joined by kPathDelimiter
+ */
+unsigned int TSChannelTree::GetChannelPath(uint64 serverConnectionHandlerID, uint64 channelID, QString* result) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return ERROR_not_connected;
+
+    QString path;
+    for (;;)
+    {
+        auto it = server->channels.constFind(channelID);
+        if (it == server->channels.constEnd())
+            return ERROR_channel_invalid_id;
+
+        path.prepend(it->name);
+        if (!it->parent_id)
+            break;
+
+        channelID = it->parent_id;
+        path.prepend(kPathDelimiter);
+    }
+    *result = path;
+    return ERROR_ok;
+}
+
+unsigned int TSChannelTree::GetChannelIDFromPath(uint64 serverConnectionHandlerID, const QString& path, uint64* result) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return ERROR_not_connected;
+
+    if (server->is_paths_dirty)
+        rebuild_paths(*server);
+
+    auto it = server->paths.constFind(path);
+    if (it == server->paths.constEnd())
+        return ERROR_channel_invalid_id;
+
+    *result = it.value();
+    return ERROR_ok;
+}
+
+unsigned int TSChannelTree::build(uint64 serverConnectionHandlerID)
+{
+    unsigned int error;
+    uint64* channelList;
+    if ((error = ts3Functions.getChannelList(serverConnectionHandlerID, &channelList)) != ERROR_ok)
+        return error;
+
+    std::unique_ptr<Server> server(new Server);
+    QVector<QPair<uint64, uint64> > parents;
+    for (int i = 0; channelList[i]; ++i)
+    {
+        const auto kChannelId = channelList[i];
+        uint64 parent;
+        Channel channel;
+        if (((error = ts3Functions.getParentChannelOfChannel(serverConnectionHandlerID, kChannelId, &parent)) != ERROR_ok)
+                || ((error = fetch(serverConnectionHandlerID, kChannelId, &channel)) != ERROR_ok))
+            break;
+
+        server->channels.insert(kChannelId, channel);
+        parents.append(qMakePair(kChannelId, parent));
+    }
+    ts3Functions.freeMemory(channelList);
+    if (error != ERROR_ok)
+        return error;
+
+    // link after all are known, the list isn't ordered parents first
+    for (const auto& pair : parents)
+        link(*server, pair.first, pair.second);
+
+    m_servers[serverConnectionHandlerID] = std::move(server);
+    return ERROR_ok;
+}
+
+unsigned int TSChannelTree::fetch(uint64 serverConnectionHandlerID, uint64 channelID, Channel* channel) const
+{
+    unsigned int error;
+    char* name;
+    if ((error = ts3Functions.getChannelVariableAsString(serverConnectionHandlerID, channelID, CHANNEL_NAME, &name)) != ERROR_ok)
+        return error;
+
+    channel->name = QString::fromUtf8(name);
+    ts3Functions.freeMemory(name);
+
+    uint64 order;
+    if ((error = ts3Functions.getChannelVariableAsUInt64(serverConnectionHandlerID, channelID, CHANNEL_ORDER, &order)) != ERROR_ok)
+        return error;
+
+    channel->order = order;
+    return ERROR_ok;
+}
+
+void TSChannelTree::link(Server& server, uint64 channelID, uint64 parentID)
+{
+    server.channels[channelID].parent_id = parentID;
+    if (parentID == 0)
+    {
+        server.roots.append(channelID);
+        return;
+    }
+    auto parent = server.channels.find(parentID);
+    if (parent != server.channels.end())
+        parent->children.append(channelID);
+}
+
+void TSChannelTree::unlink(Server& server, uint64 channelID)
+{
+    const auto kParentId = server.channels.value(channelID).parent_id;
+    if (kParentId == 0)
+    {
+        server.roots.removeOne(channelID);
+        return;
+    }
+    auto parent = server.channels.find(kParentId);
+    if (parent != server.channels.end())
+        parent->children.removeOne(channelID);
+}
+
+void TSChannelTree::remove(Server& server, uint64 channelID)
+{
+    auto it = server.channels.find(channelID);
+    if (it == server.channels.end())
+        return;
+
+    const auto kChildren = it->children;
+    for (const auto kChild : kChildren)
+        remove(server, kChild);
+
+    unlink(server, channelID);
+    server.channels.remove(channelID);
+}
+
+void TSChannelTree::rebuild_paths(const Server& server) const
+{
+    server.paths.clear();
+    server.paths.reserve(server.channels.size());
+
+    // top down, so every path is its parent's plus one name
+    QVector<QPair<uint64, QString> > stack;
+    for (const auto kRoot : server.roots)
+        stack.append(qMakePair(kRoot, server.channels[kRoot].name));
+
+    while (!stack.isEmpty())
+    {
+        const auto kEntry = stack.takeLast();
+        // same named siblings (or names containing the delimiter) share a path; the lowest, i.e. oldest, id wins
+        auto it = server.paths.find(kEntry.second);
+        if (it == server.paths.end())
+            server.paths.insert(kEntry.second, kEntry.first);
+        else if (kEntry.first < it.value())
+            it.value() = kEntry.first;
+
+        const auto& kChannel = server.channels[kEntry.first];
+        for (const auto kChild : kChannel.children)
+            stack.append(qMakePair(kChild, kEntry.second + kPathDelimiter + server.channels[kChild].name));
+    }
+    server.is_paths_dirty = false;
+}
+
+const TSChannelTree::Server* TSChannelTree::find(uint64 serverConnectionHandlerID) const
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    return (it == m_servers.end()) ? nullptr : it->second.get();
+}
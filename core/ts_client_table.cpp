@@ -0,0 +1,318 @@
+#include "core/ts_client_table.h"
+
+#include "teamspeak/public_errors.h"
+#include "teamspeak/public_rare_definitions.h"
+#include "ts3_functions.h"
+#include "plugin.h"
+
+#include "core/ts_logging_qt.h"
+
+TSClientTable* TSClientTable::m_Instance = 0;
+
+void TSClientTable::onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus)
+{
+    if (newStatus == STATUS_CONNECTION_ESTABLISHED)
+    {
+        unsigned int error;
+        if ((error = build(serverConnectionHandlerID)) != ERROR_ok)
+            TSLogging::Error("(TSClientTable) Error building client table", serverConnectionHandlerID, error);
+        else
+            emit ClientsChanged(serverConnectionHandlerID);
+    }
+    else if (newStatus == STATUS_DISCONNECTED)
+    {
+        if (m_servers.erase(serverConnectionHandlerID))
+            emit ClientsChanged(serverConnectionHandlerID);
+    }
+}
+
+void TSClientTable::onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 oldChannelID, uint64 newChannelID, int visibility)
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return;
+
+    // a client moving into a channel we aren't subscribed to leaves our view with a non-zero channel
+    auto it = server->clients.find(clientID);
+    if (newChannelID == 0 || visibility == LEAVE_VISIBILITY)
+    {
+        if (it != server->clients.end())
+        {
+            unindex(server, clientID, *it);
+            server->clients.erase(it);
+            emit ClientsChanged(serverConnectionHandlerID);
+        }
+        return;
+    }
+
+    if (oldChannelID == 0 || visibility == ENTER_VISIBILITY || it == server->clients.end())
+    {
+        Client client;
+        if (fetch(serverConnectionHandlerID, clientID, &client) != ERROR_ok)
+            return;
+
+        client.channel_id = newChannelID;
+        if (it != server->clients.end())
+        {
+            unindex(server, clientID, *it);
+            *it = client;
+        }
+        else
+            server->clients.insert(clientID, client);
+
+        index(server, clientID, client);
+        emit ClientsChanged(serverConnectionHandlerID);
+        return;
+    }
+
+    // the channel group is per channel
+    int channel_group_id;
+    if (ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientID, CLIENT_CHANNEL_GROUP_ID, &channel_group_id) != ERROR_ok)
+        channel_group_id = static_cast<int>(it->channel_group_id);
+
+    if (set_channel_group(server, clientID, &(*it), newChannelID, static_cast<uint64>(channel_group_id)))
+        emit ClientsChanged(serverConnectionHandlerID);
+}
+
+void TSClientTable::onUpdateClientEvent(uint64 serverConnectionHandlerID, anyID clientID)
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return;
+
+    auto it = server->clients.find(clientID);
+    if (it == server->clients.end())
+        return;
+
+    Client client;
+    if (fetch(serverConnectionHandlerID, clientID, &client) != ERROR_ok)
+        return;
+
+    client.channel_id = it->channel_id;
+    unindex(server, clientID, *it);
+    *it = client;
+    index(server, clientID, client);
+    emit ClientsChanged(serverConnectionHandlerID);
+}
+
+void TSClientTable::onClientChannelGroupChangedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, anyID clientID)
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return;
+
+    auto it = server->clients.find(clientID);
+    if (it != server->clients.end() && set_channel_group(server, clientID, &(*it), it->channel_id, channelGroupID))
+        emit ClientsChanged(serverConnectionHandlerID);
+}
+
+void TSClientTable::onServerGroupClientAddedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 serverGroupID)
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return;
+
+    auto it = server->clients.find(clientID);
+    if (it == server->clients.end())
+        return;
+
+    if (!it->server_groups.insert(serverGroupID))
+        return;
+
+    server->server_group_clients[serverGroupID].insert(clientID);
+    emit ClientsChanged(serverConnectionHandlerID);
+}
+
+void TSClientTable::onServerGroupClientDeletedEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 serverGroupID)
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return;
+
+    auto it = server->clients.find(clientID);
+    if (it == server->clients.end() || !it->server_groups.remove(serverGroupID))
+        return;
+
+    unindex_server_group(server, clientID, serverGroupID);
+    emit ClientsChanged(serverConnectionHandlerID);
+}
+
+bool TSClientTable::contains(uint64 serverConnectionHandlerID) const
+{
+    return find(serverConnectionHandlerID) != nullptr;
+}
+
+const TSClientTable::Client* TSClientTable::GetClient(uint64 serverConnectionHandlerID, anyID clientID) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return nullptr;
+
+    auto it = server->clients.constFind(clientID);
+    return (it == server->clients.constEnd()) ? nullptr : &it.value();
+}
+
+QVector<anyID> TSClientTable::GetClients(uint64 serverConnectionHandlerID) const
+{
+    QVector<anyID> result;
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return result;
+
+    result.reserve(server->clients.size());
+    for (auto it = server->clients.constBegin(); it != server->clients.constEnd(); ++it)
+        result.append(it.key());
+
+    return result;
+}
+
+const QSet<anyID>* TSClientTable::GetServerGroupClients(uint64 serverConnectionHandlerID, uint64 serverGroupID) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return nullptr;
+
+    auto it = server->server_group_clients.constFind(serverGroupID);
+    return (it == server->server_group_clients.constEnd()) ? nullptr : &it.value();
+}
+
+const QHash<uint64, QSet<anyID> >* TSClientTable::GetChannelGroupClients(uint64 serverConnectionHandlerID, uint64 channelGroupID) const
+{
+    auto server = find(serverConnectionHandlerID);
+    if (!server)
+        return nullptr;
+
+    auto it = server->channel_group_clients.constFind(channelGroupID);
+    return (it == server->channel_group_clients.constEnd()) ? nullptr : &it.value();
+}
+
+unsigned int TSClientTable::build(uint64 serverConnectionHandlerID)
+{
+    unsigned int error;
+    anyID* clientList;
+    if ((error = ts3Functions.getClientList(serverConnectionHandlerID, &clientList)) != ERROR_ok)
+        return error;
+
+    std::unique_ptr<Server> server(new Server);
+    for (int i = 0; clientList[i]; ++i)
+    {
+        Client client;
+        if (((error = ts3Functions.getChannelOfClient(serverConnectionHandlerID, clientList[i], &client.channel_id)) != ERROR_ok)
+                || ((error = fetch(serverConnectionHandlerID, clientList[i], &client)) != ERROR_ok))
+            break;
+
+        server->clients.insert(clientList[i], client);
+        index(server.get(), clientList[i], client);
+    }
+    ts3Functions.freeMemory(clientList);
+    if (error != ERROR_ok)
+        return error;
+
+    m_servers[serverConnectionHandlerID] = std::move(server);
+    return ERROR_ok;
+}
+
+// everything but the channel, which comes with the move events
+unsigned int TSClientTable::fetch(uint64 serverConnectionHandlerID, anyID clientID, Client* client) const
+{
+    unsigned int error;
+    int value;
+    if ((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientID, CLIENT_CHANNEL_GROUP_ID, &value)) != ERROR_ok)
+        return error;
+
+    client->channel_group_id = static_cast<uint64>(value);
+
+    if ((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientID, CLIENT_IS_CHANNEL_COMMANDER, &value)) != ERROR_ok)
+        return error;
+
+    client->is_channel_commander = (value == 1);
+
+    if ((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientID, CLIENT_TYPE, &value)) != ERROR_ok)
+        return error;
+
+    client->is_query = (value == 1);
+
+    char* str;
+    if ((error = ts3Functions.getClientVariableAsString(serverConnectionHandlerID, clientID, CLIENT_SERVERGROUPS, &str)) != ERROR_ok)
+        return error;
+
+    const auto kIsParsed = GroupSet::FromString(str, &client->server_groups);
+    ts3Functions.freeMemory(str);
+    if (!kIsParsed)
+        return ERROR_not_implemented;
+
+    if ((error = ts3Functions.getClientVariableAsString(serverConnectionHandlerID, clientID, CLIENT_UNIQUE_IDENTIFIER, &str)) != ERROR_ok)
+        return error;
+
+    client->unique_id = QString::fromUtf8(str);
+    ts3Functions.freeMemory(str);
+    return ERROR_ok;
+}
+
+void TSClientTable::index(Server* server, anyID clientID, const Client& client)
+{
+    for (auto server_group_id : client.server_groups)
+        server->server_group_clients[server_group_id].insert(clientID);
+
+    server->channel_group_clients[client.channel_group_id][client.channel_id].insert(clientID);
+}
+
+void TSClientTable::unindex(Server* server, anyID clientID, const Client& client)
+{
+    for (auto server_group_id : client.server_groups)
+        unindex_server_group(server, clientID, server_group_id);
+
+    unindex_channel_group(server, clientID, client);
+}
+
+void TSClientTable::unindex_server_group(Server* server, anyID clientID, uint64 serverGroupID)
+{
+    auto members = server->server_group_clients.find(serverGroupID);
+    if (members == server->server_group_clients.end())
+        return;
+
+    members->remove(clientID);
+    if (members->isEmpty())
+        server->server_group_clients.erase(members);
+}
+
+void TSClientTable::unindex_channel_group(Server* server, anyID clientID, const Client& client)
+{
+    auto channels = server->channel_group_clients.find(client.channel_group_id);
+    if (channels == server->channel_group_clients.end())
+        return;
+
+    auto members = channels->find(client.channel_id);
+    if (members != channels->end())
+    {
+        members->remove(clientID);
+        if (members->isEmpty())
+            channels->erase(members);
+    }
+    if (channels->isEmpty())
+        server->channel_group_clients.erase(channels);
+}
+
+bool TSClientTable::set_channel_group(Server* server, anyID clientID, Client* client, uint64 channelID, uint64 channelGroupID)
+{
+    if (client->channel_id == channelID && client->channel_group_id == channelGroupID)
+        return false;
+
+    unindex_channel_group(server, clientID, *client);
+    client->channel_id = channelID;
+    client->channel_group_id = channelGroupID;
+    server->channel_group_clients[channelGroupID][channelID].insert(clientID);
+    return true;
+}
+
+TSClientTable::Server* TSClientTable::find(uint64 serverConnectionHandlerID)
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    return (it == m_servers.end()) ? nullptr : it->second.get();
+}
+
+const TSClientTable::Server* TSClientTable::find(uint64 serverConnectionHandlerID) const
+{
+    auto it = m_servers.find(serverConnectionHandlerID);
+    return (it == m_servers.end()) ? nullptr : it->second.get();
+}
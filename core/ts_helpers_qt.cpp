@@ -8,6 +8,9 @@
 
 #include "core/ts_settings_qt.h"
 #include "core/ts_logging_qt.h"
+#include "core/ts_identity_qt.h"
+#include "core/ts_channel_tree.h"
+#include "core/ts_client_table.h"
 
 #include <QtWidgets/QApplication>
 
@@ -38,7 +41,7 @@ namespace TSHelpers
         QString lang;
         if (!TSSettings::instance()->GetLanguage(lang))
         {
-            TSLogging::Error("(TSHelpers::GetLanguage) " + TSSettings::instance()->GetLastError().text(), true);
+            TS_ERROR("(TSHelpers::GetLanguage) " + TSSettings::instance()->GetLastError().text(), true);
             return QString::null;
         }
         return lang;
@@ -46,6 +49,9 @@ namespace TSHelpers
 
     int IsClientQuery(uint64 serverConnectionHandlerID, anyID clientID) //A normal Client-Connection (Voice-Connection) has client-type 0, a Query-Connection has client-type 1.
     {
+        if (auto client = TSClientTable::instance()->GetClient(serverConnectionHandlerID, clientID))
+            return client->is_query ? 1 : 0;
+
         int type = 0;
         unsigned int error;
         if ((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientID, CLIENT_TYPE, &type)) != ERROR_ok)
@@ -87,6 +93,13 @@ namespace TSHelpers
     unsigned int GetSubChannels(uint64 serverConnectionHandlerID, uint64 channelId, QVector<uint64>* result)
     {
         unsigned int error;
+        if (TSChannelTree::instance()->contains(serverConnectionHandlerID))
+        {
+            if ((error = TSChannelTree::instance()->GetSubChannels(serverConnectionHandlerID, channelId, result)) != ERROR_ok)
+                TSLogging::Error("(TSHelpers::GetSubChannels)",serverConnectionHandlerID,error,true);
+
+            return error;
+        }
 
         uint64* channelList;
         if ((error = ts3Functions.getChannelList(serverConnectionHandlerID,&channelList)) != ERROR_ok)
@@ -102,7 +115,7 @@ namespace TSHelpers
                     break;
                 }
                 if (channel == channelId)
-                    result->append(channel);
+                    result->append(channelList[i]);
             }
             ts3Functions.freeMemory(channelList);
         }
@@ -258,14 +271,94 @@ namespace TSHelpers
 
     namespace {
 
-        unsigned int GetChannelsForGroupWhisperTargetMode(uint64 serverConnectionHandlerID, anyID myID, GroupWhisperTargetMode groupWhisperTargetMode, QVector<uint64>* targetChannels)
+        unsigned int GetParentChannel(uint64 serverConnectionHandlerID, uint64 channelID, uint64* result)
+        {
+            if (TSChannelTree::instance()->contains(serverConnectionHandlerID))
+                return TSChannelTree::instance()->GetParentChannel(serverConnectionHandlerID, channelID, result);
+
+            return ts3Functions.getParentChannelOfChannel(serverConnectionHandlerID, channelID, result);
+        }
+
+        // Group types walk the group's members in the membership indexes, the others do one pass
+        // over the client table; targetChannels is ignored if isAllChannels
+        void GetCachedWhisperClients(uint64 serverConnectionHandlerID, anyID myID, GroupWhisperType groupWhisperType, uint64 arg, bool isAllChannels, const QVector<uint64>& targetChannels, QVector<anyID>* result)
+        {
+            // e.g. sub channels of a channel without any; nobody to whisper to, not everybody
+            if (!isAllChannels && targetChannels.isEmpty())
+                return;
+
+            auto table = TSClientTable::instance();
+            if (groupWhisperType == GROUPWHISPERTYPE_SERVERGROUP)
+            {
+                auto members = table->GetServerGroupClients(serverConnectionHandlerID, arg);
+                if (!members)
+                    return;
+
+                const auto kTargetChannels = targetChannels.toList().toSet();
+                for (auto client_id : *members)
+                {
+                    if (client_id == myID)
+                        continue;
+
+                    if (isAllChannels || kTargetChannels.contains(table->GetClient(serverConnectionHandlerID, client_id)->channel_id))
+                        result->append(client_id);
+                }
+            }
+            else if (groupWhisperType == GROUPWHISPERTYPE_CHANNELGROUP)
+            {
+                auto channels = table->GetChannelGroupClients(serverConnectionHandlerID, arg);
+                if (!channels)
+                    return;
+
+                auto append = [myID, result](const QSet<anyID>& members)
+                {
+                    for (auto client_id : members)
+                    {
+                        if (client_id != myID)
+                            result->append(client_id);
+                    }
+                };
+                if (isAllChannels)
+                {
+                    for (const auto& members : *channels)
+                        append(members);
+                }
+                else
+                {
+                    for (auto channel_id : targetChannels)
+                    {
+                        auto it = channels->constFind(channel_id);
+                        if (it != channels->constEnd())
+                            append(it.value());
+                    }
+                }
+            }
+            else
+            {
+                const auto kClients = table->GetClients(serverConnectionHandlerID);
+                for (auto client_id : kClients)
+                {
+                    if (client_id == myID)
+                        continue;
+
+                    auto client = table->GetClient(serverConnectionHandlerID, client_id);
+                    if (!isAllChannels && !targetChannels.contains(client->channel_id))
+                        continue;
+
+                    if ((groupWhisperType != GROUPWHISPERTYPE_CHANNELCOMMANDER) || client->is_channel_commander)
+                        result->append(client_id);
+                }
+            }
+        }
+
+        unsigned int GetChannelsForGroupWhisperTargetMode(uint64 serverConnectionHandlerID, GroupWhisperTargetMode groupWhisperTargetMode, QVector<uint64>* targetChannels)
         {
             unsigned int error = ERROR_ok;
             if (groupWhisperTargetMode != GROUPWHISPERTARGETMODE_ALL)
             {
                 // get my channel
                 uint64 mychannel;
-                if ((error = ts3Functions.getChannelOfClient(serverConnectionHandlerID,myID,&mychannel)) != ERROR_ok)
+                if ((error = TSIdentity::instance()->GetMyChannel(serverConnectionHandlerID, &mychannel)) != ERROR_ok)
                 {
                     TSLogging::Error("(TSHelpers::GetChannelsForGroupWhisperTargetMode)",serverConnectionHandlerID,error,true);
                     return error;
@@ -276,7 +369,7 @@ namespace TSHelpers
                 else if (groupWhisperTargetMode == GROUPWHISPERTARGETMODE_PARENTCHANNEL)
                 {
                     uint64 channel;
-                    if ((error = ts3Functions.getParentChannelOfChannel(serverConnectionHandlerID,mychannel,&channel)) != ERROR_ok)
+                    if ((error = GetParentChannel(serverConnectionHandlerID,mychannel,&channel)) != ERROR_ok)
                         return error;
 
                     targetChannels->append(channel);
@@ -287,7 +380,7 @@ namespace TSHelpers
                     while(true)
                     {
                         uint64 channel;
-                        if ((error = ts3Functions.getParentChannelOfChannel(serverConnectionHandlerID,sourcechannel,&channel)) != ERROR_ok)
+                        if ((error = GetParentChannel(serverConnectionHandlerID,sourcechannel,&channel)) != ERROR_ok)
                             return error;
 
                         if (channel == 0)
@@ -314,149 +407,190 @@ namespace TSHelpers
         }
     }
 
-    unsigned int SetWhisperList(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, QString returnCode, uint64 arg)
+    unsigned int GetWhisperTargets(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, uint64 arg, QVector<uint64>* targetChannels, QVector<anyID>* targetClients)
     {
         unsigned int error = ERROR_ok;
 
         anyID myID;
-        if((error = ts3Functions.getClientID(serverConnectionHandlerID,&myID)) != ERROR_ok)
+        if((error = TSIdentity::instance()->GetMyId(serverConnectionHandlerID, &myID)) != ERROR_ok)
         {
-            TSLogging::Error("(TSHelpers::SetWhisperList)",serverConnectionHandlerID,error,true);
+            TSLogging::Error("(TSHelpers::GetWhisperTargets)",serverConnectionHandlerID,error,true);
             return error;
         }
 
         // GroupWhisperTargetMode
-        QVector<anyID> clientList;
-        QVector<uint64> targetChannelIDs;
+        auto& clientList = *targetClients;
+        auto& targetChannelIDs = *targetChannels;
+        clientList.clear();
+        targetChannelIDs.clear();
+
+        if ((groupWhisperTargetMode != GROUPWHISPERTARGETMODE_ALL)
+                && ((error = GetChannelsForGroupWhisperTargetMode(serverConnectionHandlerID,groupWhisperTargetMode,&targetChannelIDs)) != ERROR_ok))
+            return error;
 
-        if (groupWhisperTargetMode == GROUPWHISPERTARGETMODE_ALL)   // Get client list
+        if (groupWhisperType == GROUPWHISPERTYPE_SERVERGROUP)
         {
-            anyID* clients;
-            if ((error = ts3Functions.getClientList(serverConnectionHandlerID, &clients)) != ERROR_ok)
+            if (arg == (uint64)NULL)
+            {
+                TSLogging::Error("No target server group specified. Aborting.");
                 return error;
-
-            for (unsigned int i = 0; clients[i] != NULL; ++i)
+            }
+        }
+        else if (groupWhisperType == GROUPWHISPERTYPE_CHANNELGROUP)
+        {
+            // Get My Channel Group if no arg
+            if (arg == (uint64)NULL)
             {
-                if (myID != clients[i])
-                    clientList.append(clients[i]);
+                if ((error = GetClientChannelGroup(serverConnectionHandlerID,&arg)) != ERROR_ok)
+                    return error;
             }
-
-            ts3Functions.freeMemory(clients);
         }
-        else if ((error = GetChannelsForGroupWhisperTargetMode(serverConnectionHandlerID,myID,groupWhisperTargetMode,&targetChannelIDs)) != ERROR_ok)
-            return error;
 
-        // GroupWhisperType
-        if (groupWhisperType != GROUPWHISPERTYPE_ALLCLIENTS)
+        if (TSClientTable::instance()->contains(serverConnectionHandlerID))
         {
-            // We need a client list for all those, so convert channel list to clients
-            if (!targetChannelIDs.isEmpty())  // same:(groupWhisperTargetMode != GROUPWHISPERTARGETMODE_ALL);
+            if ((groupWhisperTargetMode == GROUPWHISPERTARGETMODE_ALL) || (groupWhisperType != GROUPWHISPERTYPE_ALLCLIENTS))
             {
-                for (int i = 0; i < targetChannelIDs.count(); ++i)
-                {
-                    // get clients in channel
-                    anyID *clients;
-                    if ((error = ts3Functions.getChannelClientList(serverConnectionHandlerID,targetChannelIDs.at(i),&clients)) != ERROR_ok)
-                        return error;
-
-                    for (int j=0; clients[j]!=NULL ; ++j)
-                    {
-                        if (myID != clients[j])
-                            clientList.append(clients[j]);
-                    }
-
-                    ts3Functions.freeMemory(clients);
-                }
+                GetCachedWhisperClients(serverConnectionHandlerID, myID, groupWhisperType, arg, (groupWhisperTargetMode == GROUPWHISPERTARGETMODE_ALL), targetChannelIDs, &clientList);
                 targetChannelIDs.clear();
             }
-
-            // Do the GroupWhisperType filtering
-            QVector<anyID> filteredClients;
-            if (groupWhisperType == GROUPWHISPERTYPE_SERVERGROUP)
+        }
+        else
+        {
+            if (groupWhisperTargetMode == GROUPWHISPERTARGETMODE_ALL)   // Get client list
             {
-                if (arg == (uint64)NULL)
-                {
-                    TSLogging::Error("No target server group specified. Aborting.");
+                anyID* clients;
+                if ((error = ts3Functions.getClientList(serverConnectionHandlerID, &clients)) != ERROR_ok)
                     return error;
-                }
 
-                QSet<uint64> serverGroups;
-                for (int i=0; i < clientList.count(); ++i)
+                for (unsigned int i = 0; clients[i] != NULL; ++i)
                 {
-                    if ((error = GetClientServerGroups(serverConnectionHandlerID,clientList[i],&serverGroups)) != ERROR_ok)
-                        return error;
-
-                    if (serverGroups.contains(arg))
-                        filteredClients.append(clientList[i]);
-
-                    serverGroups.clear();
+                    if (myID != clients[i])
+                        clientList.append(clients[i]);
                 }
+
+                ts3Functions.freeMemory(clients);
             }
-            else if (groupWhisperType == GROUPWHISPERTYPE_CHANNELGROUP)
+
+            // GroupWhisperType
+            if (groupWhisperType != GROUPWHISPERTYPE_ALLCLIENTS)
             {
-                // Get My Channel Group if no arg
-                if (arg == (uint64)NULL)
+                // We need a client list for all those, so convert channel list to clients
+                if (!targetChannelIDs.isEmpty())  // same:(groupWhisperTargetMode != GROUPWHISPERTARGETMODE_ALL);
                 {
-                    if ((error = GetClientChannelGroup(serverConnectionHandlerID,&arg)) != ERROR_ok)
-                        return error;
+                    for (int i = 0; i < targetChannelIDs.count(); ++i)
+                    {
+                        // get clients in channel
+                        anyID *clients;
+                        if ((error = ts3Functions.getChannelClientList(serverConnectionHandlerID,targetChannelIDs.at(i),&clients)) != ERROR_ok)
+                            return error;
+
+                        for (int j=0; clients[j]!=NULL ; ++j)
+                        {
+                            if (myID != clients[j])
+                                clientList.append(clients[j]);
+                        }
+
+                        ts3Functions.freeMemory(clients);
+                    }
+                    targetChannelIDs.clear();
                 }
 
-                for (int i=0; i < clientList.count(); ++i)
+                // Do the GroupWhisperType filtering
+                QVector<anyID> filteredClients;
+                if (groupWhisperType == GROUPWHISPERTYPE_SERVERGROUP)
                 {
-                    uint64 channelGroup;
-                    if ((error = GetClientChannelGroup(serverConnectionHandlerID, &channelGroup, clientList[i])) != ERROR_ok)
-                        break;
+                    GroupSet serverGroups;
+                    for (int i=0; i < clientList.count(); ++i)
+                    {
+                        if ((error = GetClientServerGroups(serverConnectionHandlerID,clientList[i],&serverGroups)) != ERROR_ok)
+                            return error;
 
-                    if (channelGroup == arg)
-                        filteredClients.append(clientList[i]);
+                        if (serverGroups.contains(arg))
+                            filteredClients.append(clientList[i]);
+                    }
                 }
-            }
-            else if (groupWhisperType == GROUPWHISPERTYPE_CHANNELCOMMANDER)
-            {
-                for (int i=0; i < clientList.count(); ++i)
+                else if (groupWhisperType == GROUPWHISPERTYPE_CHANNELGROUP)
                 {
-                    int isChannelCommander;
-                    if((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientList[i], CLIENT_IS_CHANNEL_COMMANDER, &isChannelCommander)) != ERROR_ok)
-                        break;
+                    for (int i=0; i < clientList.count(); ++i)
+                    {
+                        uint64 channelGroup;
+                        if ((error = GetClientChannelGroup(serverConnectionHandlerID, &channelGroup, clientList[i])) != ERROR_ok)
+                            break;
+
+                        if (channelGroup == arg)
+                            filteredClients.append(clientList[i]);
+                    }
+                }
+                else if (groupWhisperType == GROUPWHISPERTYPE_CHANNELCOMMANDER)
+                {
+                    for (int i=0; i < clientList.count(); ++i)
+                    {
+                        int isChannelCommander;
+                        if((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, clientList[i], CLIENT_IS_CHANNEL_COMMANDER, &isChannelCommander)) != ERROR_ok)
+                            break;
 
-                    if (isChannelCommander == 1)
-                        filteredClients.append(clientList[i]);
+                        if (isChannelCommander == 1)
+                            filteredClients.append(clientList[i]);
+                    }
                 }
+
+                clientList = filteredClients;
             }
+        }
+
+        return error;
+    }
+
+    unsigned int SetWhisperList(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, QString returnCode, uint64 arg)
+    {
+        unsigned int error;
 
-            clientList = filteredClients;
+        anyID myID;
+        if((error = TSIdentity::instance()->GetMyId(serverConnectionHandlerID, &myID)) != ERROR_ok)
+        {
+            TSLogging::Error("(TSHelpers::SetWhisperList)",serverConnectionHandlerID,error,true);
+            return error;
         }
 
+        QVector<anyID> clientList;
+        QVector<uint64> targetChannelIDs;
+        if ((error = GetWhisperTargets(serverConnectionHandlerID, groupWhisperType, groupWhisperTargetMode, arg, &targetChannelIDs, &clientList)) != ERROR_ok)
+            return error;
+
         if (targetChannelIDs.isEmpty() && clientList.isEmpty())
             return ERROR_ok_no_update;
         else
         {
-            TSLogging::Log("Attempting to whisper to:",serverConnectionHandlerID, LogLevel_DEBUG);
-            if (!targetChannelIDs.isEmpty())
+            // the client names cost an api call each, only look them up if they get logged
+            if (TS_LOG_ENABLED(LogLevel_DEBUG))
             {
-                QString string = "ChannelIds: ";
-                for (int i = 0; i < targetChannelIDs.size(); ++i)
+                TSLogging::Log("Attempting to whisper to:",serverConnectionHandlerID, LogLevel_DEBUG);
+                if (!targetChannelIDs.isEmpty())
                 {
-                    string.append(QString("%1").arg(targetChannelIDs.at(i)));
-                    string.append(" ");
-                }
+                    QString string = "ChannelIds: ";
+                    for (int i = 0; i < targetChannelIDs.size(); ++i)
+                    {
+                        string.append(QString::number(targetChannelIDs.at(i)));
+                        string.append(" ");
+                    }
 
-                TSLogging::Log(string.toLocal8Bit().constData(),serverConnectionHandlerID,LogLevel_DEBUG);
-            }
-            if (!clientList.isEmpty())
-            {
-                QString string = "Clients: ";
-                for (int i = 0; i<clientList.size(); ++i)
+                    TSLogging::Log(string,serverConnectionHandlerID,LogLevel_DEBUG);
+                }
+                if (!clientList.isEmpty())
                 {
-                    char name[512];
-                    if((error = ts3Functions.getClientDisplayName(serverConnectionHandlerID, clientList.at(i), name, 512)) != ERROR_ok)
-                        string.append("(Error getting client display name)");
-                    else
-                        string.append(name);
+                    QString string = "Clients: ";
+                    for (int i = 0; i<clientList.size(); ++i)
+                    {
+                        char name[512];
+                        if(ts3Functions.getClientDisplayName(serverConnectionHandlerID, clientList.at(i), name, 512) != ERROR_ok)
+                            string.append("(Error getting client display name)");
+                        else
+                            string.append(name);
 
-                    string.append(" ");
+                        string.append(" ");
+                    }
+                    TSLogging::Log(string,serverConnectionHandlerID,LogLevel_DEBUG);
                 }
-                TSLogging::Log(string.toLocal8Bit().constData(),serverConnectionHandlerID,LogLevel_DEBUG);
             }
 
             if (!targetChannelIDs.isEmpty())
@@ -506,34 +640,44 @@ namespace TSHelpers
         }
     }
 
-    unsigned int GetClientServerGroups(uint64 serverConnectionHandlerID, anyID clientID, QSet<uint64> *result)
+    unsigned int GetClientServerGroups(uint64 serverConnectionHandlerID, anyID clientID, GroupSet *result)
     {
+        if (auto client = TSClientTable::instance()->GetClient(serverConnectionHandlerID, clientID))
+        {
+            *result = client->server_groups;
+            return ERROR_ok;
+        }
+
         unsigned int error;
         char* cP_result;
         if ((error = ts3Functions.getClientVariableAsString(serverConnectionHandlerID, clientID, CLIENT_SERVERGROUPS, &cP_result)) == ERROR_ok)
         {
-            auto qsl_result = QString(cP_result).split(",",QString::SkipEmptyParts);
+            const auto kIsParsed = GroupSet::FromString(cP_result, result);
             ts3Functions.freeMemory(cP_result);
-
-            bool ok;
-            while (!qsl_result.isEmpty())
+            if (!kIsParsed)
             {
-                *result << qsl_result.takeFirst().toInt(&ok,10);
-                if (!ok)
-                {
-                    TSLogging::Error("Error converting Server Group to int");
-                    return ERROR_not_implemented;
-                }
+                TSLogging::Error("Error converting Server Group to int");
+                return ERROR_not_implemented;
             }
         }
         return error;
     }
 
-    unsigned int GetClientSelfServerGroups(uint64 serverConnectionHandlerID, QSet<uint64> *result)
+    unsigned int GetClientServerGroups(uint64 serverConnectionHandlerID, anyID clientID, QSet<uint64> *result)
+    {
+        GroupSet server_groups;
+        const auto kError = GetClientServerGroups(serverConnectionHandlerID, clientID, &server_groups);
+        for (auto server_group_id : server_groups)
+            *result << server_group_id;
+
+        return kError;
+    }
+
+    unsigned int GetClientSelfServerGroups(uint64 serverConnectionHandlerID, GroupSet *result)
     {
         unsigned int error;
         anyID myID;
-        if((error = ts3Functions.getClientID(serverConnectionHandlerID,&myID)) != ERROR_ok)
+        if((error = TSIdentity::instance()->GetMyId(serverConnectionHandlerID, &myID)) != ERROR_ok)
         {
             TSLogging::Error("(TSHelpers::GetClientSelfServerGroups)",serverConnectionHandlerID,error,true);
             return error;
@@ -542,16 +686,31 @@ namespace TSHelpers
         return GetClientServerGroups(serverConnectionHandlerID,myID,result);
     }
 
+    unsigned int GetClientSelfServerGroups(uint64 serverConnectionHandlerID, QSet<uint64> *result)
+    {
+        GroupSet server_groups;
+        const auto kError = GetClientSelfServerGroups(serverConnectionHandlerID, &server_groups);
+        for (auto server_group_id : server_groups)
+            *result << server_group_id;
+
+        return kError;
+    }
+
     unsigned int GetClientChannelGroup(uint64 serverConnectionHandlerID, uint64* result, anyID clientId)
     {
         unsigned int error;
         if (clientId == (anyID)NULL)    // use my id
         {
-            if((error = ts3Functions.getClientID(serverConnectionHandlerID,&clientId)) != ERROR_ok)
-            {
+            if ((error = TSIdentity::instance()->GetMyChannelGroup(serverConnectionHandlerID, result)) != ERROR_ok)
                 TSLogging::Error("(GetClientChannelGroup)",serverConnectionHandlerID,error,true);
-                return error;
-            }
+
+            return error;
+        }
+
+        if (auto client = TSClientTable::instance()->GetClient(serverConnectionHandlerID, clientId))
+        {
+            *result = client->channel_group_id;
+            return ERROR_ok;
         }
 
         int channelGroupId;
@@ -617,6 +776,16 @@ namespace TSHelpers
     {
         QString path = QString::null;
         unsigned int error;
+        if (TSChannelTree::instance()->contains(serverConnectionHandlerID))
+        {
+            if ((error = TSChannelTree::instance()->GetChannelPath(serverConnectionHandlerID, channel_id, &path)) != ERROR_ok)
+            {
+                TSLogging::Error("(GetChannelPath) Error getting channel path.", serverConnectionHandlerID, error);
+                return QString::null;
+            }
+            return path;
+        }
+
         while (true)
         {
             auto name = GetChannelVariableAsQString(serverConnectionHandlerID, channel_id, CHANNEL_NAME);
@@ -640,6 +809,17 @@ namespace TSHelpers
     uint64 GetChannelIDFromPath(uint64 serverConnectionHandlerID, QString path_q)
     {
         uint64 channel_id;
+        if (TSChannelTree::instance()->contains(serverConnectionHandlerID))
+        {
+            const auto kError = TSChannelTree::instance()->GetChannelIDFromPath(serverConnectionHandlerID, path_q, &channel_id);
+            if (kError != ERROR_ok)
+            {
+                TSLogging::Error("(GetChannelIDFromPath) Error getting channel id from channel names.", serverConnectionHandlerID, kError);
+                return 0;
+            }
+            return channel_id;
+        }
+
         QList<QByteArray> dummy;
         auto path_list = path_q.split("__CH_DELIM__");
         path_list.append("");
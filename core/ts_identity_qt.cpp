@@ -0,0 +1,116 @@
+#include "core/ts_identity_qt.h"
+
+#include "teamspeak/public_errors.h"
+#include "teamspeak/public_rare_definitions.h"
+#include "ts3_functions.h"
+#include "plugin.h"
+
+#include "core/ts_logging_qt.h"
+
+TSIdentity* TSIdentity::m_Instance = 0;
+
+void TSIdentity::onConnectStatusChangeEvent(uint64 serverConnectionHandlerID, int newStatus)
+{
+    if (newStatus == STATUS_CONNECTION_ESTABLISHED)
+    {
+        unsigned int error;
+        Identity identity;
+        if ((error = ts3Functions.getClientID(serverConnectionHandlerID, &identity.my_id)) != ERROR_ok)
+        {
+            TSLogging::Error("(TSIdentity::onConnectStatusChangeEvent) Error getting my clientID", serverConnectionHandlerID, error);
+            return;
+        }
+        if ((error = ts3Functions.getChannelOfClient(serverConnectionHandlerID, identity.my_id, &identity.channel_id)) != ERROR_ok)
+        {
+            TSLogging::Error("(TSIdentity::onConnectStatusChangeEvent) Error getting my clients channel id", serverConnectionHandlerID, error);
+            return;
+        }
+        m_identities.insert(serverConnectionHandlerID, identity);
+    }
+    else if (newStatus == STATUS_DISCONNECTED)
+        clear(serverConnectionHandlerID);
+}
+
+void TSIdentity::onClientMoveEvent(uint64 serverConnectionHandlerID, anyID clientID, uint64 newChannelID)
+{
+    auto it = m_identities.find(serverConnectionHandlerID);
+    if (it == m_identities.end() || it->my_id != clientID)
+        return;
+
+    if (it->channel_id != newChannelID)
+    {
+        it->channel_id = newChannelID;  // 0 when kicked or banned from the server, until the disconnect clears us
+        it->channel_group_id = 0;   // the channel group is per channel; fetch again when asked for
+    }
+}
+
+void TSIdentity::onClientChannelGroupChangedEvent(uint64 serverConnectionHandlerID, uint64 channelGroupID, anyID clientID)
+{
+    auto it = m_identities.find(serverConnectionHandlerID);
+    if (it != m_identities.end() && it->my_id == clientID)
+        it->channel_group_id = channelGroupID;
+}
+
+void TSIdentity::clear(uint64 serverConnectionHandlerID)
+{
+    m_identities.remove(serverConnectionHandlerID);
+}
+
+unsigned int TSIdentity::GetMyId(uint64 serverConnectionHandlerID, anyID* result)
+{
+    auto it = m_identities.constFind(serverConnectionHandlerID);
+    if (it != m_identities.constEnd())
+    {
+        *result = it->my_id;
+        return ERROR_ok;
+    }
+    return ts3Functions.getClientID(serverConnectionHandlerID, result);
+}
+
+unsigned int TSIdentity::GetMyChannel(uint64 serverConnectionHandlerID, uint64* result)
+{
+    auto it = m_identities.constFind(serverConnectionHandlerID);
+    if (it != m_identities.constEnd())
+    {
+        *result = it->channel_id;
+        return ERROR_ok;
+    }
+
+    unsigned int error;
+    anyID my_id;
+    if ((error = ts3Functions.getClientID(serverConnectionHandlerID, &my_id)) != ERROR_ok)
+        return error;
+
+    return ts3Functions.getChannelOfClient(serverConnectionHandlerID, my_id, result);
+}
+
+unsigned int TSIdentity::GetMyChannelGroup(uint64 serverConnectionHandlerID, uint64* result)
+{
+    unsigned int error;
+    auto it = m_identities.find(serverConnectionHandlerID);
+    if (it != m_identities.end() && it->channel_group_id != 0)
+    {
+        *result = it->channel_group_id;
+        return ERROR_ok;
+    }
+
+    anyID my_id;
+    if ((error = GetMyId(serverConnectionHandlerID, &my_id)) != ERROR_ok)
+        return error;
+
+    int channel_group_id;
+    if ((error = ts3Functions.getClientVariableAsInt(serverConnectionHandlerID, my_id, CLIENT_CHANNEL_GROUP_ID, &channel_group_id)) != ERROR_ok)
+        return error;
+
+    *result = static_cast<uint64>(channel_group_id);
+    if (it != m_identities.end())
+        it->channel_group_id = *result;
+
+    return ERROR_ok;
+}
+
+bool TSIdentity::IsMe(uint64 serverConnectionHandlerID, anyID clientID)
+{
+    anyID my_id;
+    return (GetMyId(serverConnectionHandlerID, &my_id) == ERROR_ok) && (my_id == clientID);
+}
@@ -1,5 +1,9 @@
 #include "core/ts_logging_qt.h"
 
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QVector>
+
 #include "teamspeak/public_errors.h"
 #include "teamspeak/public_errors_rare.h"
 
@@ -7,30 +11,223 @@
 #include "plugin.h"
 
 #include "core/ts_settings_qt.h"
+#include "core/async_log.h"
+
+namespace {
+
+// Set once by the first SetAsync(true) and never deleted, producers may still hold it
+std::atomic<AsyncLog*> g_async_log{nullptr};
+
+AsyncLog* running_async_log()
+{
+    auto async_log = g_async_log.load(std::memory_order_acquire);
+    return (async_log && async_log->is_running()) ? async_log : nullptr;
+}
+
+std::atomic<int> g_log_level{LogLevel_DEVEL};   // nothing filtered until asked for
+
+ErrorLimiter& error_limiter()
+{
+    static ErrorLimiter limiter;
+    return limiter;
+}
+
+// Resolved resource paths by the pack they were resolved for; TSSettings keeps the pack names current
+struct ResourcePath
+{
+    QString pack;
+    QString path;
+    bool is_resolved = false;
+};
+
+struct ResourceCache
+{
+    QMutex mutex;
+    ResourcePath error_sound;
+    ResourcePath info_icon;
+};
+
+ResourceCache& resource_cache()
+{
+    static ResourceCache cache;
+    return cache;
+}
+
+// Appends the error text of the sdk and writes to the client log and chat; the synchronous part of Error
+void log_error(QString message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent, quint64 suppressed)
+{
+    if (suppressed > 0)
+        message.append(QString(" (%1 similar suppressed)").arg(suppressed));
+
+    if (error != NULL)
+    {
+        char* errorMsg;
+        if(ts3Functions.getErrorMessage(error, &errorMsg) == ERROR_ok)
+        {
+            QTextStream(&message) << ": " << errorMsg;
+            ts3Functions.freeMemory(errorMsg);
+        }
+    }
+
+    ts3Functions.logMessage(message.toLocal8Bit().constData(), LogLevel_ERROR, ts3plugin_name(), serverConnectionHandlerID);
+    TSLogging::PrintError(message, serverConnectionHandlerID, isSoundSilent);
+}
+
+}  // namespace
+
+QVector<ErrorLimiter::Counter> TSLogging::GetErrorCounters()
+{
+    return error_limiter().counters();
+}
+
+void TSLogging::FlushSuppressedErrors()
+{
+    for (const auto& entry : error_limiter().take_pending())
+    {
+        const auto kSite = entry.call_site.line ? QString("%1:%2").arg(entry.call_site.site).arg(entry.call_site.line)
+                                                : QString::fromUtf8(entry.call_site.site);
+        LogFormat(0, LogLevel_WARNING, "%1 (error %2) suppressed %3 times", kSite, entry.error, entry.suppressed);
+    }
+}
+
+void TSLogging::SetLogLevel(LogLevel logLevel)
+{
+    g_log_level.store(logLevel, std::memory_order_relaxed);
+}
+
+LogLevel TSLogging::GetLogLevel()
+{
+    return static_cast<LogLevel>(g_log_level.load(std::memory_order_relaxed));
+}
+
+bool TSLogging::IsLogged(LogLevel logLevel)
+{
+    return Rank(logLevel) <= Rank(GetLogLevel());
+}
+
+QString TSLogging::LogArg::toString() const
+{
+    switch (type)
+    {
+    case kInt:
+        return QString::number(i);
+    case kUInt:
+        return QString::number(u);
+    case kDouble:
+        return QString::number(d);
+    case kString:
+        return *s;
+    case kUtf8:
+        return QString::fromUtf8(c);
+    }
+    return QString();
+}
+
+QString TSLogging::Format(const char* format, const QString* args, int count)
+{
+    const auto kFormat = QString::fromUtf8(format);
+    QString result;
+    result.reserve(kFormat.size() + 16 * count);
+    for (int i = 0; i < kFormat.size(); ++i)
+    {
+        const auto kC = kFormat.at(i);
+        if (kC == '%' && (i + 1) < kFormat.size())
+        {
+            const auto kIndex = kFormat.at(i + 1).digitValue();
+            if (kIndex >= 1 && kIndex <= count)
+            {
+                result.append(args[kIndex - 1]);
+                ++i;
+                continue;
+            }
+        }
+        result.append(kC);
+    }
+    return result;
+}
+
+void TSLogging::LogArgs(uint64 serverConnectionHandlerID, LogLevel logLevel, LogFormatString format, const LogArg* args, int count)
+{
+    if (!IsLogged(logLevel))
+        return;
+
+    if (auto async_log = running_async_log())
+    {
+        if (async_log->push_format(format.c, args, count, serverConnectionHandlerID, logLevel))
+            return;
+    }
+
+    QVector<QString> strings;
+    strings.reserve(count);
+    for (int i = 0; i < count; ++i)
+        strings.append(args[i].toString());
+
+    Log(Format(format.c, strings.constData(), count), serverConnectionHandlerID, logLevel);
+}
+
+bool TSLogging::SetAsync(bool isAsync)
+{
+    auto async_log = g_async_log.load(std::memory_order_acquire);
+    if (!isAsync)
+    {
+        if (async_log)
+            async_log->stop();
+        return true;
+    }
+
+    if (!async_log)
+    {
+        async_log = new AsyncLog();
+        g_async_log.store(async_log, std::memory_order_release);
+    }
+    return async_log->start();
+}
+
+bool TSLogging::IsAsync()
+{
+    return running_async_log() != nullptr;
+}
+
+quint64 TSLogging::GetDroppedCount()
+{
+    auto async_log = g_async_log.load(std::memory_order_acquire);
+    return async_log ? async_log->dropped_count() : 0;
+}
 
 bool TSLogging::GetErrorSound(QString &in)
 {
     QString pack;
     if (TSSettings::instance()->GetSoundPack(pack))
     {
-        // Find the path to the soundpack
-        char path[PATH_BUFSIZE];
-        ts3Functions.getResourcesPath(path, PATH_BUFSIZE);
-        QString path_qstr(path);
-        path_qstr.append("sound/" + pack);
-
-        QSettings cfg(path_qstr + "/settings.ini", QSettings::IniFormat);
-        auto snd_qstr = cfg.value("soundfiles/SERVER_ERROR").toString();
-        if (snd_qstr.isEmpty() != true)
+        auto& cache = resource_cache();
+        QMutexLocker locker(&cache.mutex);
+        if (!cache.error_sound.is_resolved || cache.error_sound.pack != pack)
         {
-            // towatch: QSettings insists on eliminating the double quotas '\"' on read
-            // no, I won't spend one more minute creating a regexp that fits for a fragging error sound that should be available via the api.
-            snd_qstr.remove("play(");
-            snd_qstr.remove(")");
+            // Find the path to the soundpack
+            char path[PATH_BUFSIZE];
+            ts3Functions.getResourcesPath(path, PATH_BUFSIZE);
+            QString path_qstr(path);
+            path_qstr.append("sound/" + pack);
+
+            cache.error_sound.path.clear();
+            QSettings cfg(path_qstr + "/settings.ini", QSettings::IniFormat);
+            auto snd_qstr = cfg.value("soundfiles/SERVER_ERROR").toString();
+            if (snd_qstr.isEmpty() != true)
+            {
+                // towatch: QSettings insists on eliminating the double quotas '\"' on read
+                // no, I won't spend one more minute creating a regexp that fits for a fragging error sound that should be available via the api.
+                snd_qstr.remove("play(");
+                snd_qstr.remove(")");
 
-            path_qstr.append("/" + snd_qstr);
-            in = path_qstr;
+                path_qstr.append("/" + snd_qstr);
+                cache.error_sound.path = path_qstr;
+            }
+            cache.error_sound.pack = pack;
+            cache.error_sound.is_resolved = true;
         }
+        if (!cache.error_sound.path.isEmpty())
+            in = cache.error_sound.path;
+
         return true; // Here so that the user setting of "No Sound" (and speech synthesis? don't throw errors)
     }
     return false;
@@ -41,11 +238,19 @@ bool TSLogging::GetInfoIcon(QString &in)
     QString pack;
     if (TSSettings::instance()->GetIconPack(pack))
     {
-        // Find the path to the skin
-        char path[PATH_BUFSIZE];
-        ts3Functions.getResourcesPath(path, PATH_BUFSIZE);
-        QString path_qstr(path);
-        in = (path_qstr + "gfx/" + pack + "/16x16_message_info.png");
+        auto& cache = resource_cache();
+        QMutexLocker locker(&cache.mutex);
+        if (!cache.info_icon.is_resolved || cache.info_icon.pack != pack)
+        {
+            // Find the path to the skin
+            char path[PATH_BUFSIZE];
+            ts3Functions.getResourcesPath(path, PATH_BUFSIZE);
+            QString path_qstr(path);
+            cache.info_icon.path = (path_qstr + "gfx/" + pack + "/16x16_message_info.png");
+            cache.info_icon.pack = pack;
+            cache.info_icon.is_resolved = true;
+        }
+        in = cache.info_icon.path;
         return true;
     }
     return false;
@@ -82,20 +287,43 @@ void TSLogging::PlayErrorSound(uint64 serverConnectionHandlerID)
     }
 }
 
+void TSLogging::Error(const ErrorLimiter::CallSite& callSite, QString message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent)
+{
+    quint64 suppressed;
+    if (!error_limiter().admit(callSite, error, &suppressed))
+        return;
+
+    if (auto async_log = running_async_log())
+    {
+        async_log->push_error(message, serverConnectionHandlerID, error, isSoundSilent, suppressed);
+        return;
+    }
+
+    log_error(message, serverConnectionHandlerID, error, isSoundSilent, suppressed);
+}
+
 void TSLogging::Error(QString message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent)
 {
+    Error(ErrorLimiter::CallSite{nullptr, 0}, message, serverConnectionHandlerID, error, isSoundSilent);
+}
 
-    if (error != NULL)
+void TSLogging::ErrorLiteral(const char* message, uint64 serverConnectionHandlerID, unsigned int error, bool isSoundSilent)
+{
+    quint64 suppressed;
+    if (!error_limiter().admit(ErrorLimiter::CallSite{message, 0}, error, &suppressed))
+        return;
+
+    if (auto async_log = running_async_log())
     {
-        char* errorMsg;
-        if(ts3Functions.getErrorMessage(error, &errorMsg) == ERROR_ok)
-        {
-            QTextStream(&message) << ": " << errorMsg;
-            ts3Functions.freeMemory(errorMsg);
-        }
+        async_log->push_error_literal(message, serverConnectionHandlerID, error, isSoundSilent, suppressed);
+        return;
     }
 
-    Log(message,serverConnectionHandlerID,LogLevel_ERROR);
+    log_error(QString::fromUtf8(message), serverConnectionHandlerID, error, isSoundSilent, suppressed);
+}
+
+void TSLogging::PrintError(QString message, uint64 serverConnectionHandlerID, bool isSoundSilent)
+{
     if (!isSoundSilent)
         PlayErrorSound(serverConnectionHandlerID);
 
@@ -167,5 +395,14 @@ void TSLogging::Print(QString message, uint64 serverConnectionHandlerID, LogLeve
 
 void TSLogging::Log(QString message, uint64 serverConnectionHandlerID, LogLevel logLevel)
 {
+    if (!IsLogged(logLevel))
+        return;
+
+    if (auto async_log = running_async_log())
+    {
+        async_log->push(message, serverConnectionHandlerID, logLevel);
+        return;
+    }
+
     ts3Functions.logMessage(message.toLocal8Bit().constData(), logLevel, ts3plugin_name(), serverConnectionHandlerID);
 }
@@ -7,6 +7,7 @@
 
 #include "core/ts_helpers_qt.h"
 #include "core/ts_logging_qt.h"
+#include "core/group_cache.h"
 #include "plugin.h"
 #include "ts3_functions.h"
 
@@ -21,6 +22,29 @@ uint64 TSServerInfo::getServerConnectionHandlerID() const
 }
 
 QString TSServerInfo::getName() const
+{
+    return m_is_cached ? m_name : fetch_name();
+}
+
+QString TSServerInfo::getUniqueId() const
+{
+    return m_is_cached ? m_unique_id : fetch_unique_id();
+}
+
+uint64 TSServerInfo::getDefaultChannelGroup() const
+{
+    return m_is_cached ? m_default_channel_group : fetch_default_channel_group();
+}
+
+void TSServerInfo::refresh()
+{
+    m_name = fetch_name();
+    m_unique_id = fetch_unique_id();
+    m_default_channel_group = fetch_default_channel_group();
+    m_is_cached = !m_unique_id.isEmpty();
+}
+
+QString TSServerInfo::fetch_name() const
 {
     unsigned int error;
     char* s_name;
@@ -34,7 +58,7 @@ QString TSServerInfo::getName() const
     return name;
 }
 
-QString TSServerInfo::getUniqueId() const
+QString TSServerInfo::fetch_unique_id() const
 {
     unsigned int error;
     char* s_val;
@@ -48,7 +72,7 @@ QString TSServerInfo::getUniqueId() const
     return val;
 }
 
-uint64 TSServerInfo::getDefaultChannelGroup() const
+uint64 TSServerInfo::fetch_default_channel_group() const
 {
     unsigned int error;
     uint64 result;
@@ -62,46 +86,87 @@ uint64 TSServerInfo::getDefaultChannelGroup() const
 
 uint64 TSServerInfo::GetServerGroupId(QString name) const
 {
-    return (m_server_groups.key(name, (uint64)NULL));
+    return m_server_group_index.id(name);
 }
 
 QString TSServerInfo::GetServerGroupName(uint64 id) const
 {
-    if (m_server_groups.contains(id))
-        return m_server_groups.value(id);
-
-    return QString::null;
+    return m_server_group_index.name(id);
 }
 
+// Of channel groups sharing a name, the one with the highest id is returned
 uint64 TSServerInfo::GetChannelGroupId(QString name) const
 {
-    auto list = m_channel_groups.keys(name);
-    auto elementCount = list.size();
-    if (elementCount == 0)
-        return (uint64)NULL;
-    else if (elementCount == 1)
-        return list.at(0);
-    else
+    return m_channel_group_index.id(name);
+}
+
+QString TSServerInfo::GetChannelGroupName(uint64 id) const
+{
+    return m_channel_group_index.name(id);
+}
+
+GroupSet TSServerInfo::GetServerGroupIds(const QStringList& names) const
+{
+    GroupSet result;
+    for (const auto& name : names)
     {
-        uint64 highest = 0;
-        for (int i = 0; i < elementCount; ++i)
-        {
-            uint64 e_key = list.at(i);
-            if (e_key > highest)
-                highest = e_key;
-        }
-        return highest;
+        const auto kId = GetServerGroupId(name);
+        if (kId)
+            result.insert(kId);
     }
+    return result;
+}
 
-    //return (m_ChannelGroups.key(name,(uint64)NULL));
+GroupSet TSServerInfo::GetChannelGroupIds(const QStringList& names) const
+{
+    GroupSet result;
+    for (const auto& name : names)
+    {
+        const auto kId = GetChannelGroupId(name);
+        if (kId)
+            result.insert(kId);
+    }
+    return result;
 }
 
-QString TSServerInfo::GetChannelGroupName(uint64 id) const
+void TSServerInfo::load_group_cache()
 {
-    if (m_channel_groups.contains(id))
-        return m_channel_groups.value(id);
+    if (m_is_group_cache_loaded || (m_is_server_groups_live && m_is_channel_groups_live))
+        return;
+
+    QMap<uint64, QString> server_groups;
+    QMap<uint64, QString> channel_groups;
+    if (!GroupCache::Load(getUniqueId(), &server_groups, &channel_groups))
+        return;
+
+    m_is_group_cache_loaded = true;
+    if (!m_is_server_groups_live)
+    {
+        const auto kDelta = GroupListDelta::diff(m_server_groups, server_groups);
+        m_server_groups.swap(server_groups);
+        m_server_group_index.build(m_server_groups, false);
+        if (!kDelta.isEmpty())
+        {
+            emit serverGroupListDelta(m_server_connection_id, kDelta);
+            emit serverGroupListUpdated(m_server_connection_id, m_server_groups);
+        }
+    }
+    if (!m_is_channel_groups_live)
+    {
+        const auto kDelta = GroupListDelta::diff(m_channel_groups, channel_groups);
+        m_channel_groups.swap(channel_groups);
+        m_channel_group_index.build(m_channel_groups, true);
+        if (!kDelta.isEmpty())
+        {
+            emit channelGroupListDelta(m_server_connection_id, kDelta);
+            emit channelGroupListUpdated(m_server_connection_id, m_channel_groups);
+        }
+    }
+}
 
-    return QString::null;
+void TSServerInfo::save_group_cache()
+{
+    GroupCache::Save(getUniqueId(), m_server_groups, m_channel_groups);
 }
 
 void TSServerInfo::onServerGroupListEvent(uint64 server_group_id, const char *name, int type, int icon_id, int save_db)
@@ -111,15 +176,33 @@ void TSServerInfo::onServerGroupListEvent(uint64 server_group_id, const char *na
     Q_UNUSED(save_db);
 
     if (!m_is_server_groups_updating)
-        m_server_groups.clear();
+        m_server_groups_pending.clear();
 
-    m_server_groups.insert(server_group_id, name);
+    m_server_groups_pending.insert(server_group_id, name);
     m_is_server_groups_updating = true;
 }
 
 void TSServerInfo::onServerGroupListFinishedEvent()
 {
+    if (!m_is_server_groups_updating)   // no groups listed, keep the ones we have
+        m_server_groups_pending = m_server_groups;
+
     m_is_server_groups_updating = false;
+    const auto kDelta = GroupListDelta::diff(m_server_groups, m_server_groups_pending);
+    m_server_groups.swap(m_server_groups_pending);
+    m_server_groups_pending.clear();
+    // listeners of TSServersInfo already got the cached list; only a first list from nowhere is always emitted
+    const auto kIsFirstList = !m_is_server_groups_live && !m_is_group_cache_loaded;
+    m_is_server_groups_live = true;
+    if (!kDelta.isEmpty())
+    {
+        m_server_group_index.build(m_server_groups, false);
+        save_group_cache();
+        emit serverGroupListDelta(m_server_connection_id, kDelta);
+    }
+    else if (!kIsFirstList)
+        return;
+
     emit serverGroupListUpdated(m_server_connection_id, m_server_groups);
 }
 
@@ -132,14 +215,98 @@ void TSServerInfo::onChannelGroupListEvent(uint64 channel_group_id, const char *
     Q_UNUSED(save_db);
 
     if (!m_is_channel_groups_updating)
-        m_channel_groups.clear();
+        m_channel_groups_pending.clear();
 
-    m_channel_groups.insert(channel_group_id, name);
+    m_channel_groups_pending.insert(channel_group_id, name);
     m_is_channel_groups_updating = true;
 }
 
 void TSServerInfo::onChannelGroupListFinishedEvent()
 {
+    if (!m_is_channel_groups_updating)   // no groups listed, keep the ones we have
+        m_channel_groups_pending = m_channel_groups;
+
     m_is_channel_groups_updating = false;
+    const auto kDelta = GroupListDelta::diff(m_channel_groups, m_channel_groups_pending);
+    m_channel_groups.swap(m_channel_groups_pending);
+    m_channel_groups_pending.clear();
+    // listeners of TSServersInfo already got the cached list; only a first list from nowhere is always emitted
+    const auto kIsFirstList = !m_is_channel_groups_live && !m_is_group_cache_loaded;
+    m_is_channel_groups_live = true;
+    if (!kDelta.isEmpty())
+    {
+        m_channel_group_index.build(m_channel_groups, true);
+        save_group_cache();
+        emit channelGroupListDelta(m_server_connection_id, kDelta);
+    }
+    else if (!kIsFirstList)
+        return;
+
     emit channelGroupListUpdated(m_server_connection_id, m_channel_groups);
 }
+
+GroupListDelta GroupListDelta::diff(const QMap<uint64, QString>& before, const QMap<uint64, QString>& after)
+{
+    // both are ordered by id
+    GroupListDelta delta;
+    auto b = before.constBegin();
+    auto a = after.constBegin();
+    while (b != before.constEnd() || a != after.constEnd())
+    {
+        if (a == after.constEnd() || (b != before.constEnd() && b.key() < a.key()))
+        {
+            delta.removed.append(b.key());
+            ++b;
+        }
+        else if (b == before.constEnd() || a.key() < b.key())
+        {
+            delta.added.insert(a.key(), a.value());
+            ++a;
+        }
+        else
+        {
+            if (b.value() != a.value())
+                delta.renamed.insert(a.key(), a.value());
+
+            ++b;
+            ++a;
+        }
+    }
+    return delta;
+}
+
+void TSServerInfo::GroupIndex::build(const QMap<uint64, QString>& groups, bool is_prefer_highest_id)
+{
+    names.clear();
+    ids.clear();
+    folded_ids.clear();
+    names.reserve(groups.size());
+    ids.reserve(groups.size());
+    folded_ids.reserve(groups.size());
+
+    // ascending ids; on duplicate names either the first or the last one wins
+    for (auto it = groups.constBegin(); it != groups.constEnd(); ++it)
+    {
+        names.insert(it.key(), it.value());
+        if (is_prefer_highest_id || !ids.contains(it.value()))
+            ids.insert(it.value(), it.key());
+
+        const auto kFolded = it.value().toCaseFolded();
+        if (is_prefer_highest_id || !folded_ids.contains(kFolded))
+            folded_ids.insert(kFolded, it.key());
+    }
+}
+
+uint64 TSServerInfo::GroupIndex::id(const QString& name) const
+{
+    auto it = ids.constFind(name);
+    if (it != ids.constEnd())
+        return it.value();
+
+    return folded_ids.value(name.toCaseFolded(), (uint64)NULL);
+}
+
+QString TSServerInfo::GroupIndex::name(uint64 id) const
+{
+    return names.value(id, QString::null);
+}
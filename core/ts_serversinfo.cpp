@@ -8,7 +8,10 @@
 
 TSServersInfo::TSServersInfo(QObject* parent)
 	: QObject(parent)
-{}
+{
+    // the group list deltas may be delivered to listeners on other threads (queued)
+    qRegisterMetaType<GroupListDelta>();
+}
 
 TSServerInfo* TSServersInfo::get_server_info(uint64 server_connection_id, bool create_on_not_exist)
 {
@@ -29,6 +32,9 @@ TSServerInfo* TSServersInfo::get_server_info(uint64 server_connection_id, bool c
             auto server_info = new TSServerInfo(this, server_connection_id);
             m_server_infos.insert(server_connection_id, server_info);
             connect(server_info, &TSServerInfo::serverGroupListUpdated, this, &TSServersInfo::serverGroupListUpdated, Qt::UniqueConnection);
+            connect(server_info, &TSServerInfo::serverGroupListDelta, this, &TSServersInfo::serverGroupListDelta, Qt::UniqueConnection);
+            connect(server_info, &TSServerInfo::channelGroupListUpdated, this, &TSServersInfo::channelGroupListUpdated, Qt::UniqueConnection);
+            connect(server_info, &TSServerInfo::channelGroupListDelta, this, &TSServersInfo::channelGroupListDelta, Qt::UniqueConnection);
             return server_info;
         }
         else
@@ -41,7 +47,7 @@ TSServerInfo* TSServersInfo::get_server_info(uint64 server_connection_id, bool c
 
 uint64 TSServersInfo::find_server_by_unique_id(QString server_id)
 {
-    uint64 server_connection_id = 0;
+    if (!m_is_unique_ids_seeded)
     {
         uint64* servers;
         if (ts3Functions.getServerConnectionHandlerList(&servers) == ERROR_ok)
@@ -49,21 +55,39 @@ uint64 TSServersInfo::find_server_by_unique_id(QString server_id)
             for (auto server = servers; *server; ++server)
             {
                 auto ts_server_info = get_server_info(*server, true);
-                if (ts_server_info && (server_id == ts_server_info->getUniqueId()))
-                {
-                    server_connection_id = ts_server_info->getServerConnectionHandlerID();
-                    break;
-                }
+                if (!ts_server_info)
+                    continue;
+
+                ts_server_info->refresh();
+                update_unique_id(*server, ts_server_info->getUniqueId());
             }
             ts3Functions.freeMemory(servers);
+            m_is_unique_ids_seeded = true;
         }
     }
-    return server_connection_id;
+    return m_unique_ids.value(server_id, 0);
 }
 
 void TSServersInfo::onConnectStatusChangeEvent(uint64 server_connection_id, int new_status, unsigned int error_number)
 {
-    if (new_status == STATUS_DISCONNECTED)
+    if (new_status == STATUS_CONNECTION_ESTABLISHING)
+    {
+        // the server's unique id is known by now; the group lists may still be coming
+        auto ts_server_info = get_server_info(server_connection_id, true);
+        if (ts_server_info)
+            ts_server_info->load_group_cache();
+    }
+    else if (new_status == STATUS_CONNECTION_ESTABLISHED)
+    {
+        auto ts_server_info = get_server_info(server_connection_id, true);
+        if (ts_server_info)
+        {
+            ts_server_info->refresh();
+            update_unique_id(server_connection_id, ts_server_info->getUniqueId());
+            ts_server_info->load_group_cache();
+        }
+    }
+    else if (new_status == STATUS_DISCONNECTED)
     {
         if (m_server_infos.contains(server_connection_id))
         {
@@ -73,11 +97,54 @@ void TSServersInfo::onConnectStatusChangeEvent(uint64 server_connection_id, int
 
             m_server_infos.remove(server_connection_id);
         }
+        update_unique_id(server_connection_id, QString::null);
     }
 
     emit connectStatusChanged(server_connection_id, new_status, error_number);
 }
 
+void TSServersInfo::onServerUpdatedEvent(uint64 server_connection_id)
+{
+    auto ts_server_info = get_server_info(server_connection_id, false);
+    if (!ts_server_info)
+        return;
+
+    ts_server_info->refresh();
+    update_unique_id(server_connection_id, ts_server_info->getUniqueId());
+}
+
+// With several tabs on the same server the index points to one of them, preferring the first connected
+void TSServersInfo::update_unique_id(uint64 server_connection_id, const QString& unique_id)
+{
+    QString old_unique_id;
+    for (auto it = m_unique_ids.begin(); it != m_unique_ids.end(); ++it)
+    {
+        if (it.value() == server_connection_id)
+        {
+            old_unique_id = it.key();
+            m_unique_ids.erase(it);
+            break;
+        }
+    }
+
+    if (!unique_id.isEmpty() && !m_unique_ids.contains(unique_id))
+        m_unique_ids.insert(unique_id, server_connection_id);
+
+    if (old_unique_id.isEmpty() || (old_unique_id == unique_id))
+        return;
+
+    // hand the old unique id over to another tab on that server, if any
+    for (auto it = m_server_infos.constBegin(); it != m_server_infos.constEnd(); ++it)
+    {
+        const auto& ts_server_info = it.value();
+        if ((it.key() != server_connection_id) && ts_server_info && ts_server_info->is_cached() && (ts_server_info->getUniqueId() == old_unique_id))
+        {
+            m_unique_ids.insert(old_unique_id, it.key());
+            break;
+        }
+    }
+}
+
 void TSServersInfo::onServerGroupListEvent(uint64 server_connection_id, uint64 server_group_id, const char *name, int type, int icon_id, int save_db)
 {
     auto ts_server_info = get_server_info(server_connection_id, true);
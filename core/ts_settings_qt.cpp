@@ -1,25 +1,63 @@
 #include "core/ts_settings_qt.h"
 #include "core/ts_logging_qt.h"
 
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QMutexLocker>
+
 #include "plugin.h"
 
 TSSettings* TSSettings::m_Instance = 0;
 
 TSSettings::TSSettings(){}
 
-void TSSettings::Init(QString tsConfigPath)
+TSSettings::~TSSettings()
 {
-    const auto kName = QString(ts3plugin_name()).simplified().append("_SetDbConn");
-    m_SettingsDb = QSqlDatabase::addDatabase("QSQLITE", kName);
-    m_SettingsDb.setDatabaseName(tsConfigPath + "settings.db");
-    if (!QFile::exists(m_SettingsDb.database(kName).databaseName()))
-        TSLogging::Log(QString("Couldn't open settings.db: %1 does not exist.").arg(m_SettingsDb.database().databaseName()));
+    delete m_watcher;
 
-    if (!m_SettingsDb.isValid())
-        TSLogging::Log("Database is not valid.");
+    qDeleteAll(m_statements);
+    m_statements.clear();
+    if (m_SettingsDb.isValid())
+    {
+        m_SettingsDb.close();
+        m_SettingsDb = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_ConnectionName);
+    }
+}
+
+void TSSettings::Init(QString tsConfigPath)
+{
+    // The connection is opened on the first query
+    m_ConnectionName = QString(ts3plugin_name()).simplified().append("_SetDbConn");
+    m_SettingsDbPath = tsConfigPath + "settings.db";
+    if (!QFile::exists(m_SettingsDbPath))
+    {
+        TSLogging::Log(QString("Couldn't open settings.db: %1 does not exist.").arg(m_SettingsDbPath));
+        return;
+    }
 
-    if(!m_SettingsDb.open())
-        TSLogging::Error("Error loading settings.db; aborting init", 0, NULL);
+    // The client writes its settings while running; reload the snapshot when it does
+    if (!m_watcher)
+    {
+        m_watcher = new QFileSystemWatcher();
+        QObject::connect(m_watcher, &QFileSystemWatcher::fileChanged, [this](const QString& path)
+        {
+            onSettingsFileChanged(path);
+        });
+        // to pick up a WAL created later
+        QObject::connect(m_watcher, &QFileSystemWatcher::directoryChanged, [this](const QString& path)
+        {
+            if (QFile::exists(m_SettingsDbPath + "-wal") && !m_watcher->files().contains(m_SettingsDbPath + "-wal"))
+                onSettingsFileChanged(path);
+        });
+    }
+    const auto kConfigDir = QFileInfo(m_SettingsDbPath).absolutePath();
+    if (!m_watcher->directories().contains(kConfigDir))
+        m_watcher->addPath(kConfigDir);
+    for (const auto& file : {m_SettingsDbPath, m_SettingsDbPath + "-wal"})
+    {
+        if (!m_watcher->files().contains(file) && QFile::exists(file))
+            m_watcher->addPath(file);
+    }
 }
 
 //! Find out which Sound Pack the user is currently using
@@ -30,7 +68,7 @@ void TSSettings::Init(QString tsConfigPath)
  */
 bool TSSettings::GetSoundPack(QString &result)
 {
-    if (!(GetValueFromQuery("SELECT value FROM Notifications WHERE key='SoundPack'", result, false)))
+    if (!(GetValueFromSnapshot("Notifications", "SoundPack", result, false)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetSoundPack) "));
         return false;
@@ -46,7 +84,7 @@ bool TSSettings::GetSoundPack(QString &result)
  */
 bool TSSettings::GetIconPack(QString &result)
 {
-    if (!(GetValueFromQuery("SELECT value FROM Application WHERE key='IconPack'", result,false)))
+    if (!(GetValueFromSnapshot("Application", "IconPack", result, false)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetIconPack) "));
         return false;
@@ -62,7 +100,7 @@ bool TSSettings::GetIconPack(QString &result)
  */
 bool TSSettings::GetDefaultCaptureProfile(QString &result)
 {
-    if (!(GetValueFromQuery("SELECT value FROM Profiles WHERE key='DefaultCaptureProfile'", result,false)))
+    if (!(GetValueFromSnapshot("Profiles", "DefaultCaptureProfile", result, false)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetDefaultCaptureProfile) "));
         return false;
@@ -79,8 +117,7 @@ bool TSSettings::GetDefaultCaptureProfile(QString &result)
  */
 bool TSSettings::GetPreProcessorData(QString profile, QString &result)
 {
-    QString query("SELECT value FROM Profiles WHERE key='Capture/" + profile + "/PreProcessing'");
-    if (!(GetValueFromQuery(query, result,false)))
+    if (!(GetValueFromSnapshot("Profiles", "Capture/" + profile + "/PreProcessing", result, false)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetPreProcessorData) "));
         return false;
@@ -96,8 +133,7 @@ bool TSSettings::GetPreProcessorData(QString profile, QString &result)
  */
 bool TSSettings::GetBookmarks(QStringList &result)
 {
-    QString query("SELECT value FROM Bookmarks");
-    if (!(GetValuesFromQuery(query, result)))
+    if (!(GetValuesFromSnapshot("Bookmarks", result)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetBookmarks) "));
         return false;
@@ -139,8 +175,7 @@ bool TSSettings::GetBookmarkByServerUID(QString sUID, QMap<QString, QString> &re
  */
 bool TSSettings::GetContacts(QStringList &result)
 {
-    QString query("SELECT value FROM Contacts");
-    if (!(GetValuesFromQuery(query, result)))
+    if (!(GetValuesFromSnapshot("Contacts", result)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetContacts) "));
         return false;
@@ -167,8 +202,7 @@ bool TSSettings::GetContacts(QStringList &result)
  */
 bool TSSettings::GetLanguage(QString &result)
 {
-    QString query("SELECT value FROM Application WHERE key='Language'"); //"","enUS","deDE"...
-    if (!(GetValueFromQuery(query, result,true)))
+    if (!(GetValueFromSnapshot("Application", "Language", result, true))) //"","enUS","deDE"...
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(GetLanguage) "));
         result = QLocale::system().name();
@@ -183,8 +217,7 @@ bool TSSettings::GetLanguage(QString &result)
 bool TSSettings::Is3DSoundEnabled(bool &result)
 {
     QString qstr_result;
-    QString query("SELECT value FROM Application WHERE key='3DSoundEnabled'");
-    if (!(GetValueFromQuery(query, qstr_result,false)))
+    if (!(GetValueFromSnapshot("Application", "3DSoundEnabled", qstr_result, false)))
     {
         error_qsql.setDriverText(error_qsql.driverText().prepend("(Is3DSoundEnabled) "));
         return false;
@@ -195,18 +228,61 @@ bool TSSettings::Is3DSoundEnabled(bool &result)
 
 bool TSSettings::Set3DSoundEnabled(bool val)
 {
-    QSqlQuery q_query(QString("UPDATE Application SET value='%1' WHERE key='3DSoundEnabled'").arg((val)?"1":"0"), m_SettingsDb);
-    if (!q_query.exec())
+    // The only write; a writable connection just for it, the shared one stays read-only
+    const auto kName = m_ConnectionName + "_rw";
+    auto is_ok = false;
     {
-        auto sql_error = q_query.lastError();
-        if (sql_error.isValid())
-            error_qsql=sql_error;
+        auto db = QSqlDatabase::addDatabase("QSQLITE", kName);
+        db.setDatabaseName(m_SettingsDbPath);
+        if (!db.open())
+        {
+            error_qsql = db.lastError();
+            error_qsql.setDriverText(error_qsql.driverText().prepend("(Set3DSoundEnabled) "));
+        }
         else
-            SetError("Unknown error on query.exec.");
-
-        return false;
+        {
+            QSqlQuery q_query(db);
+            q_query.prepare("UPDATE Application SET value=? WHERE key='3DSoundEnabled'");
+            q_query.addBindValue((val)?"1":"0");
+            if (!q_query.exec())
+            {
+                auto sql_error = q_query.lastError();
+                if (sql_error.isValid())
+                    error_qsql=sql_error;
+                else
+                    SetError("Unknown error on query.exec.");
+            }
+            else
+                is_ok = true;
+        }
+        db.close();
     }
-    return true;
+    QSqlDatabase::removeDatabase(kName);
+    if (is_ok)
+        ReloadSnapshot(true);
+
+    return is_ok;
+}
+
+//! Reload the settings held in memory
+/*!
+ * \brief TSSettings::Refresh Reloads the tables of the snapshot now instead of on the next file change notification
+ * \return true on success, false when an error has occurred
+ */
+bool TSSettings::Refresh()
+{
+    return ReloadSnapshot(true);
+}
+
+//! Changes whenever the content of the snapshot changed
+/*!
+ * \brief TSSettings::GetSnapshotGeneration
+ * \return a counter, to be compared with a previous result
+ */
+quint64 TSSettings::GetSnapshotGeneration()
+{
+    QMutexLocker locker(&m_cache_mutex);
+    return m_snapshot_generation;
 }
 
 //! Returns the last SQL Error; optional usage when a TSSettings function doesn't return true
@@ -249,7 +325,14 @@ QMap<QString, QString> TSSettings::GetMapFromValue(QString value)
  */
 bool TSSettings::GetValueFromQuery(QString query, QString &result, bool isEmptyValid) // provides first valid
 {
-    QSqlQuery q_query(query, m_SettingsDb);
+    QMutexLocker locker(&m_db_mutex);
+    auto statement = GetStatement(query);
+    if (!statement)
+        return false;
+
+    auto& q_query = *statement;
+    StatementFinisher finisher{q_query};
+
     if(!q_query.exec())
     {
         QSqlError sql_error = q_query.lastError();
@@ -335,16 +418,22 @@ bool TSSettings::GetValueFromQuery(QString query, QString &result, bool isEmptyV
     }
 }
 
-//! Get multiple values from the TS Database
+//! Get multiple key value pairs from the TS Database
 /*!
- * \brief TSSettings::GetValuesFromQuery
- * \param query a sql query string
- * \param result the result will be put in here
+ * \brief TSSettings::GetRowsFromQuery
+ * \param query a sql query string selecting two columns
+ * \param result the result will be put in here, empty values included
  * \return true on success, false when an error has occurred
  */
-bool TSSettings::GetValuesFromQuery(QString query, QStringList &result) //proper result list
+bool TSSettings::GetRowsFromQuery(QString query, Rows &result)
 {
-    QSqlQuery q_query(query, m_SettingsDb);
+    QMutexLocker locker(&m_db_mutex);
+    auto statement = GetStatement(query);
+    if (!statement)
+        return false;
+
+    auto& q_query = *statement;
+    StatementFinisher finisher{q_query};
     if(!q_query.exec())
     {
         auto sql_error = q_query.lastError();
@@ -390,14 +479,232 @@ bool TSSettings::GetValuesFromQuery(QString query, QStringList &result) //proper
 
                 return false;
             }
-            QString qstr(q_query.value(0).toString());
-            if (qstr.isEmpty() != true)
-                result.append(qstr);
+            result.append(qMakePair(q_query.value(0).toString(), q_query.value(1).toString()));
         }
         return true;
     }
 }
 
+//! Get a single value from the in-memory copy of a table
+/*!
+ * \brief TSSettings::GetValueFromSnapshot Get a single value, loading its table on first use
+ * \param table the table name
+ * \param key the key
+ * \param result the result will be put in here
+ * \param isEmptyValid determines, if an empty or missing value is considered an error
+ * \return true on success, false when an error has occurred
+ */
+bool TSSettings::GetValueFromSnapshot(const QString& table, const QString& key, QString& result, bool isEmptyValid)
+{
+    QMutexLocker locker(&m_cache_mutex);
+    auto snapshot_table = GetSnapshotTable(table);
+    if (!snapshot_table)
+        return false;
+
+    const auto kRow = snapshot_table->index.value(key, -1);
+    const auto kValue = (kRow == -1) ? QString() : snapshot_table->rows.at(kRow).second;
+    if (kValue.isEmpty() && !isEmptyValid)
+    {
+        SetError("Unknown error.");
+        return false;
+    }
+    result = kValue;
+    return true;
+}
+
+//! Get the non-empty values of a table from its in-memory copy
+/*!
+ * \brief TSSettings::GetValuesFromSnapshot Get all values of a table, loading it on first use
+ * \param table the table name
+ * \param result the result will be put in here
+ * \return true on success, false when an error has occurred
+ */
+bool TSSettings::GetValuesFromSnapshot(const QString& table, QStringList& result)
+{
+    QMutexLocker locker(&m_cache_mutex);
+    auto snapshot_table = GetSnapshotTable(table);
+    if (!snapshot_table)
+        return false;
+
+    for (const auto& row : snapshot_table->rows)
+    {
+        if (!row.second.isEmpty())
+            result.append(row.second);
+    }
+    return true;
+}
+
+//! Get a table of the snapshot; call with m_cache_mutex held
+/*!
+ * \brief TSSettings::GetSnapshotTable
+ * \param table the table name
+ * \return the table, nullptr when loading it failed
+ */
+const TSSettings::SnapshotTable* TSSettings::GetSnapshotTable(const QString& table)
+{
+    auto it = m_snapshot.constFind(table);
+    if (it != m_snapshot.constEnd())
+        return &(*it);
+
+    SnapshotTable snapshot_table;
+    if (!LoadSnapshotTable(table, snapshot_table))
+        return nullptr;
+
+    return &(*m_snapshot.insert(table, snapshot_table));
+}
+
+//! Read a table of the TS Database
+/*!
+ * \brief TSSettings::LoadSnapshotTable
+ * \param table the table name, one of those the getters use
+ * \param result the result will be put in here
+ * \return true on success, false when an error has occurred
+ */
+bool TSSettings::LoadSnapshotTable(const QString& table, SnapshotTable& result)
+{
+    if (!GetRowsFromQuery("SELECT key, value FROM " + table, result.rows))
+        return false;
+
+    for (int i = 0; i < result.rows.size(); ++i)
+        result.index.insert(result.rows.at(i).first, i);
+
+    return true;
+}
+
+//! Reload the tables of the snapshot
+/*!
+ * \brief TSSettings::ReloadSnapshot Reloads the loaded tables, replacing those whose content changed
+ * \param isForced if false, only reloads if another connection committed since the last reload
+ * \return true on success, false when an error has occurred; a table failing to load keeps its previous content
+ */
+bool TSSettings::ReloadSnapshot(bool isForced)
+{
+    // data_version changes with each commit of any other connection, like the client's
+    QString data_version;
+    GetValueFromQuery("PRAGMA data_version", data_version, false);
+
+    QStringList tables;
+    {
+        QMutexLocker locker(&m_cache_mutex);
+        if (!isForced && !data_version.isEmpty() && data_version == m_data_version)
+            return true;
+
+        m_data_version = data_version;
+        tables = m_snapshot.keys();
+    }
+
+    auto is_ok = true;
+    for (const auto& table : tables)
+    {
+        SnapshotTable snapshot_table;
+        if (!LoadSnapshotTable(table, snapshot_table))
+        {
+            is_ok = false;
+            continue;
+        }
+
+        QMutexLocker locker(&m_cache_mutex);
+        auto& current = m_snapshot[table];
+        if (current.rows == snapshot_table.rows)
+            continue;
+
+        current = snapshot_table;
+        ++m_snapshot_generation;
+    }
+    return is_ok;
+}
+
+//! Reload the snapshot when settings.db or its WAL was written
+/*!
+ * \brief TSSettings::onSettingsFileChanged QFileSystemWatcher::fileChanged and directoryChanged handler
+ * \param path the changed path
+ */
+void TSSettings::onSettingsFileChanged(const QString& path)
+{
+    Q_UNUSED(path);
+
+    // the WAL comes and goes, and a file replaced instead of written to drops out of the watch list
+    const auto kWatched = m_watcher->files();
+    for (const auto& file : {m_SettingsDbPath, m_SettingsDbPath + "-wal"})
+    {
+        if (!kWatched.contains(file) && QFile::exists(file))
+            m_watcher->addPath(file);
+    }
+
+    // Reload right away, so the getters stay free of queries
+    ReloadSnapshot(false);
+}
+
+//! Open the shared connection if it isn't yet
+/*!
+ * \brief TSSettings::OpenDatabase Lazily opens settings.db read-only with a shared cache
+ * \return true on success, false when an error has occurred
+ */
+bool TSSettings::OpenDatabase()
+{
+    if (m_SettingsDb.isOpen())
+        return true;
+
+    if (!m_SettingsDb.isValid())
+    {
+        if (m_ConnectionName.isEmpty())
+        {
+            SetError("(OpenDatabase) Not initialized.");
+            return false;
+        }
+        m_SettingsDb = QSqlDatabase::addDatabase("QSQLITE", m_ConnectionName);
+        m_SettingsDb.setDatabaseName(m_SettingsDbPath);
+        m_SettingsDb.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_ENABLE_SHARED_CACHE");
+        if (!m_SettingsDb.isValid())
+        {
+            SetError("(OpenDatabase) Database is not valid.");
+            return false;
+        }
+    }
+
+    if (!m_SettingsDb.open())
+    {
+        error_qsql = m_SettingsDb.lastError();
+        error_qsql.setDriverText(error_qsql.driverText().prepend("(OpenDatabase) "));
+        return false;
+    }
+    return true;
+}
+
+//! Get the prepared statement of a query, preparing it on first use
+/*!
+ * \brief TSSettings::GetStatement Prepared statement cache
+ * \param query an sql query string, placeholders for variable parts
+ * \return the statement, owned by the cache; call with m_db_mutex held. nullptr when an error has occurred
+ */
+QSqlQuery* TSSettings::GetStatement(const QString& query)
+{
+    auto statement = m_statements.value(query);
+    if (statement)
+        return statement;
+
+    if (!OpenDatabase())
+        return nullptr;
+
+    QSqlQuery q_query(m_SettingsDb);
+    if (!q_query.prepare(query))
+    {
+        auto sql_error = q_query.lastError();
+        if (sql_error.isValid())
+        {
+            error_qsql=sql_error;
+            error_qsql.setDriverText(error_qsql.driverText().prepend("(q_query.prepare()) "));
+        }
+        else
+            SetError("Unknown error on query.prepare.");
+
+        return nullptr;
+    }
+    statement = new QSqlQuery(q_query);
+    m_statements.insert(query, statement);
+    return statement;
+}
+
 //! Manually creates a custom SQL Error
 /*!
  * \brief TSSettings::SetError encapsulates an error string in a sql error
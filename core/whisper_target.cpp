@@ -0,0 +1,137 @@
+#include "core/whisper_target.h"
+
+#include <algorithm>
+
+#include "teamspeak/public_errors.h"
+#include "teamspeak/public_errors_rare.h"
+#include "ts3_functions.h"
+#include "plugin.h"
+
+#include "core/ts_logging_qt.h"
+#include "core/ts_helpers_qt.h"
+#include "core/ts_identity_qt.h"
+#include "core/ts_client_table.h"
+
+WhisperTarget::WhisperTarget(uint64 serverConnectionHandlerID, GroupWhisperType groupWhisperType, GroupWhisperTargetMode groupWhisperTargetMode, uint64 arg, QObject* parent)
+    : QObject(parent)
+    , m_sch_id(serverConnectionHandlerID)
+    , m_type(groupWhisperType)
+    , m_mode(groupWhisperTargetMode)
+    , m_arg(arg)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(kDebounceMs);
+    connect(&m_debounce, &QTimer::timeout, this, &WhisperTarget::refresh);
+    m_poll.setInterval(kPollMs);
+    connect(&m_poll, &QTimer::timeout, this, &WhisperTarget::poll);
+    connect(TSClientTable::instance(), &TSClientTable::ClientsChanged, this, &WhisperTarget::onClientsChanged);
+}
+
+unsigned int WhisperTarget::start()
+{
+    m_is_active = true;
+    m_debounce.stop();
+    if (!TSClientTable::instance()->contains(m_sch_id))
+    {
+        TSLogging::Log("(WhisperTarget) No client table for this server; polling the whisper targets", m_sch_id, LogLevel_WARNING);
+        m_poll.start();
+    }
+    return update(true);
+}
+
+void WhisperTarget::stop()
+{
+    m_is_active = false;
+    m_debounce.stop();
+    m_poll.stop();
+}
+
+void WhisperTarget::onClientsChanged(uint64 serverConnectionHandlerID)
+{
+    if (!m_is_active || serverConnectionHandlerID != m_sch_id)
+        return;
+
+    if (!TSClientTable::instance()->contains(m_sch_id))
+    {
+        // disconnected; the server forgets the whisper list
+        m_is_pushed = false;
+        m_debounce.stop();
+        return;
+    }
+
+    // coalesce, but don't let a steady stream of changes postpone the update forever
+    if (!m_debounce.isActive())
+        m_debounce.start();
+}
+
+void WhisperTarget::refresh()
+{
+    if (m_is_active)
+        update(false);
+}
+
+void WhisperTarget::poll()
+{
+    // the table showed up (reconnect); its changes are followed from here on
+    if (TSClientTable::instance()->contains(m_sch_id))
+    {
+        m_poll.stop();
+        refresh();
+        return;
+    }
+
+    int con_status;
+    if ((ts3Functions.getConnectionStatus(m_sch_id, &con_status) != ERROR_ok) || (con_status == STATUS_DISCONNECTED))
+    {
+        // the reconnect builds the table and signals it
+        m_poll.stop();
+        m_is_pushed = false;
+        return;
+    }
+    refresh();
+}
+
+unsigned int WhisperTarget::update(bool force)
+{
+    unsigned int error;
+    QVector<uint64> channels;
+    QVector<anyID> clients;
+    if ((error = TSHelpers::GetWhisperTargets(m_sch_id, m_type, m_mode, m_arg, &channels, &clients)) != ERROR_ok)
+    {
+        TSLogging::Error("(WhisperTarget) Error resolving whisper targets", m_sch_id, error, true);
+        return error;
+    }
+
+    std::sort(channels.begin(), channels.end());
+    std::sort(clients.begin(), clients.end());
+    if (!force && m_is_pushed && (channels == m_channels) && (clients == m_clients))
+        return ERROR_ok_no_update;
+
+    anyID my_id;
+    if ((error = TSIdentity::instance()->GetMyId(m_sch_id, &my_id)) != ERROR_ok)
+    {
+        TSLogging::Error("(WhisperTarget)", m_sch_id, error, true);
+        return error;
+    }
+
+    // nobody left to whisper to clears the list; channel_list and client_list stay empty
+    auto channel_list = channels;
+    if (!channel_list.isEmpty())
+        channel_list.append(0);
+
+    auto client_list = clients;
+    if (!client_list.isEmpty())
+        client_list.append(0);
+
+    if ((error = ts3Functions.requestClientSetWhisperList(m_sch_id, my_id, channel_list.isEmpty() ? nullptr : channel_list.constData(), client_list.isEmpty() ? nullptr : client_list.constData(), nullptr)) != ERROR_ok)
+    {
+        TSLogging::Error("(WhisperTarget) Error setting whisper list", m_sch_id, error, true);
+        return error;
+    }
+
+    m_channels = channels;
+    m_clients = clients;
+    m_is_pushed = true;
+    emit TargetsChanged(m_sch_id, m_channels, m_clients);
+    return ERROR_ok;
+}
@@ -1,6 +1,7 @@
 #include "volume/dsp_volume.h"
 
 #include "volume/db.h"
+#include "core/frame_analysis.h"
 
 const float GAIN_FADE_RATE = (400.0f);	// Rate to fade at (dB per second)
 
@@ -136,4 +137,5 @@ void DspVolume::doProcess(short *samples, int sampleCount)
         int temp = samples[i_sample] * mix_gain;
         samples[i_sample] = qBound(-32768, temp, 32767);
     }
+    FrameAnalysis::invalidate(samples);
 }
@@ -3,9 +3,9 @@
 #include <QtCore/QVarLengthArray>
 #include <QtCore/qmath.h>
 
-#include "volume/dsp_helpers.h"
 #include "volume/db.h"
 #include "core/ts_logging_qt.h"
+#include "core/frame_analysis.h"
 
 DspVolumeAGMU::DspVolumeAGMU(QObject *parent)
 {
@@ -17,7 +17,7 @@ DspVolumeAGMU::DspVolumeAGMU(QObject *parent)
 void DspVolumeAGMU::process(int16_t* samples, int32_t sample_count, int32_t channels)
 {
     sample_count = sample_count * channels;
-    auto peak = getPeak(samples, sample_count);
+    auto peak = FrameAnalysis::get(samples, sample_count).peak;
     peak = qMax(m_peak, peak);
     if (peak != m_peak)
     {
@@ -0,0 +1,356 @@
+#include "volume/loudest_talkers.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "volume/db.h"
+#include "core/frame_analysis.h"
+
+namespace {
+    const anyID kAllClients = 0xffff;
+}
+
+LoudestTalkers::LoudestTalkers(int k)
+    : m_k(qMax(1, k))
+    , m_heap(m_k)
+{}
+
+quint32 LoudestTalkers::hash(quint64 key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<quint32>(key);
+}
+
+qint64 LoudestTalkers::now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writer side lookup
+int LoudestTalkers::find(quint64 key) const
+{
+    auto index = hash(key);
+    for (int probe = 0; probe < kCapacity; ++probe, ++index)
+    {
+        const auto kIndex = static_cast<int>(index & (kCapacity - 1));
+        const auto kKey = m_clients[kIndex].key.load(std::memory_order_relaxed);
+        if (kKey == key && !m_clients[kIndex].is_tombstone)
+            return kIndex;
+
+        if (kKey == 0)
+            break;
+    }
+    return -1;
+}
+
+// A slot is free when empty, tombstoned, or off the heap with no block for kExpireMs;
+// the key of a reused slot is replaced and never cleared, so the probe chains stay intact
+int LoudestTalkers::acquire(quint64 key, qint64 now_ms)
+{
+    auto index = find(key);
+    if (index >= 0)
+        return index;
+
+    auto hashed = hash(key);
+    for (int probe = 0; probe < kCapacity; ++probe, ++hashed)
+    {
+        const auto kIndex = static_cast<int>(hashed & (kCapacity - 1));
+        auto& client = m_clients[kIndex];
+        const auto kIsExpired = client.heap_pos < 0 && (now_ms - client.updated_ms.load(std::memory_order_relaxed) > kExpireMs);
+        if (client.key.load(std::memory_order_relaxed) == 0 || client.is_tombstone || kIsExpired)
+        {
+            client.is_tombstone = false;
+            client.level_db.store(-200.0f, std::memory_order_relaxed);
+            client.heap_pos = -1;
+            client.key.store(key, std::memory_order_relaxed);
+            return kIndex;
+        }
+    }
+    return -1;
+}
+
+void LoudestTalkers::release(int index)
+{
+    auto& client = m_clients[index];
+    if (client.heap_pos >= 0)
+        heap_remove(client.heap_pos);
+
+    client.is_tombstone = true;     // keeps the probe chains intact
+}
+
+// Applies the pending remove requests
+void LoudestTalkers::drain()
+{
+    auto head = m_queue_head.load(std::memory_order_relaxed);
+    const auto kTail = m_queue_tail.load(std::memory_order_acquire);
+    if (head == kTail)
+        return;
+
+    for (; head != kTail; ++head)
+    {
+        const auto kKey = m_queue[head & (kQueueSize - 1)].load(std::memory_order_relaxed);
+        if ((kKey & 0xffff) != kAllClients)
+        {
+            const auto kIndex = find(kKey);
+            if (kIndex >= 0)
+                release(kIndex);
+
+            continue;
+        }
+
+        const auto kSch = kKey >> 16;
+        for (int i = 0; i < kCapacity; ++i)
+        {
+            const auto kClientKey = m_clients[i].key.load(std::memory_order_relaxed);
+            if (kClientKey != 0 && !m_clients[i].is_tombstone && (kClientKey >> 16) == kSch)
+                release(i);
+        }
+    }
+    m_queue_head.store(head, std::memory_order_release);
+}
+
+// Takes the clients that stopped talking off the heap, at most every kStaleMs; O(K)
+void LoudestTalkers::expire(qint64 now_ms)
+{
+    if (now_ms - m_expire_ms < kStaleMs)
+        return;
+
+    m_expire_ms = now_ms;
+    for (int pos = 0; pos < m_heap_size.load(std::memory_order_relaxed);)
+    {
+        const auto& kClient = m_clients[m_heap[pos].load(std::memory_order_relaxed)];
+        if (now_ms - kClient.updated_ms.load(std::memory_order_relaxed) <= kStaleMs)
+        {
+            ++pos;
+            continue;
+        }
+
+        // the last entry moves in and may sift either way; start over
+        heap_remove(pos);
+        pos = 0;
+    }
+}
+
+float LoudestTalkers::level(int heap_pos) const
+{
+    return m_clients[m_heap[heap_pos].load(std::memory_order_relaxed)].level_db.load(std::memory_order_relaxed);
+}
+
+void LoudestTalkers::swap(int a, int b)
+{
+    const auto kA = m_heap[a].load(std::memory_order_relaxed);
+    const auto kB = m_heap[b].load(std::memory_order_relaxed);
+    m_heap[a].store(kB, std::memory_order_relaxed);
+    m_heap[b].store(kA, std::memory_order_relaxed);
+    m_clients[kB].heap_pos = a;
+    m_clients[kA].heap_pos = b;
+}
+
+void LoudestTalkers::sift_up(int pos)
+{
+    while (pos > 0)
+    {
+        const auto kParent = (pos - 1) / 2;
+        if (level(kParent) <= level(pos))
+            break;
+
+        swap(pos, kParent);
+        pos = kParent;
+    }
+}
+
+void LoudestTalkers::sift_down(int pos)
+{
+    const auto kSize = m_heap_size.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        auto smallest = pos;
+        const auto kLeft = 2 * pos + 1;
+        const auto kRight = kLeft + 1;
+        if (kLeft < kSize && level(kLeft) < level(smallest))
+            smallest = kLeft;
+        if (kRight < kSize && level(kRight) < level(smallest))
+            smallest = kRight;
+        if (smallest == pos)
+            break;
+
+        swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void LoudestTalkers::heap_remove(int pos)
+{
+    const auto kLast = m_heap_size.load(std::memory_order_relaxed) - 1;
+    m_clients[m_heap[pos].load(std::memory_order_relaxed)].heap_pos = -1;
+    if (pos != kLast)
+    {
+        const auto kMoved = m_heap[kLast].load(std::memory_order_relaxed);
+        m_heap[pos].store(kMoved, std::memory_order_relaxed);
+        m_clients[kMoved].heap_pos = pos;
+    }
+    m_heap_size.store(kLast, std::memory_order_relaxed);
+    if (pos != kLast)
+    {
+        const auto kMoved = m_heap[pos].load(std::memory_order_relaxed);
+        sift_up(pos);
+        sift_down(m_clients[kMoved].heap_pos);
+    }
+}
+
+void LoudestTalkers::begin_write()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void LoudestTalkers::end_write()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void LoudestTalkers::update(uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels, int sample_rate)
+{
+    const auto kAnalysis = FrameAnalysis::get(samples, frame_count * channels);
+    update_level(sch_id, client_id, lin2db(kAnalysis.rms), frame_count, sample_rate);
+}
+
+//! Feed a block level of a client
+/*!
+ * \brief LoudestTalkers::update_level playback thread only; O(log K)
+ * \param sch_id the server connection
+ * \param client_id the client
+ * \param block_db the block rms, dBFS
+ * \param frame_count frames in the block, for the release
+ * \param sample_rate the sample rate
+ */
+void LoudestTalkers::update_level(uint64 sch_id, anyID client_id, float block_db, int frame_count, int sample_rate)
+{
+    const auto kNow = now_ms();
+    begin_write();
+    drain();
+    expire(kNow);
+
+    const auto kIndex = acquire(make_key(sch_id, client_id), kNow);
+    if (kIndex < 0)
+    {
+        end_write();
+        return;
+    }
+
+    auto& client = m_clients[kIndex];
+    const auto kPrevious = client.level_db.load(std::memory_order_relaxed);
+    const auto kRelease = m_release_db_per_s * frame_count / sample_rate;
+    const auto kLevel = (block_db >= kPrevious) ? block_db : qMax(block_db, kPrevious - kRelease);
+    client.level_db.store(kLevel, std::memory_order_relaxed);
+    client.updated_ms.store(kNow, std::memory_order_relaxed);
+
+    const auto kSize = m_heap_size.load(std::memory_order_relaxed);
+    if (client.heap_pos >= 0)
+    {
+        if (kLevel < kPrevious)
+            sift_up(client.heap_pos);
+        else
+            sift_down(client.heap_pos);
+    }
+    else if (kSize < m_k)
+    {
+        m_heap[kSize].store(kIndex, std::memory_order_relaxed);
+        client.heap_pos = kSize;
+        m_heap_size.store(kSize + 1, std::memory_order_relaxed);
+        sift_up(kSize);
+    }
+    else if (kLevel > level(0))
+    {
+        m_clients[m_heap[0].load(std::memory_order_relaxed)].heap_pos = -1;
+        m_heap[0].store(kIndex, std::memory_order_relaxed);
+        client.heap_pos = 0;
+        sift_down(0);
+    }
+    end_write();
+}
+
+bool LoudestTalkers::remove(uint64 sch_id, anyID client_id)
+{
+    const auto kTail = m_queue_tail.load(std::memory_order_relaxed);
+    if (kTail - m_queue_head.load(std::memory_order_acquire) >= static_cast<quint32>(kQueueSize))
+        return false;
+
+    m_queue[kTail & (kQueueSize - 1)].store(make_key(sch_id, client_id), std::memory_order_relaxed);
+    m_queue_tail.store(kTail + 1, std::memory_order_release);
+    return true;
+}
+
+bool LoudestTalkers::remove(uint64 sch_id)
+{
+    return remove(sch_id, kAllClients);
+}
+
+int LoudestTalkers::top(Entry* result, int max_count) const
+{
+    std::vector<Entry> entries(m_k);
+    std::vector<qint64> updated_ms(m_k);
+    std::array<quint64, kQueueSize> removals;     // requested, not yet applied to the view
+    int count;
+    int removal_count;
+    for (;;)
+    {
+        const auto kSequence = m_sequence.load(std::memory_order_acquire);
+        if (kSequence & 1)
+            continue;
+
+        count = m_heap_size.load(std::memory_order_relaxed);
+        for (int i = 0; i < count; ++i)
+        {
+            const auto& kClient = m_clients[m_heap[i].load(std::memory_order_relaxed)];
+            const auto kKey = kClient.key.load(std::memory_order_relaxed);
+            entries[i].sch_id = kKey >> 16;
+            entries[i].client_id = static_cast<anyID>(kKey & 0xffff);
+            entries[i].level_db = kClient.level_db.load(std::memory_order_relaxed);
+            updated_ms[i] = kClient.updated_ms.load(std::memory_order_relaxed);
+        }
+
+        const auto kHead = m_queue_head.load(std::memory_order_relaxed);
+        const auto kTail = m_queue_tail.load(std::memory_order_acquire);
+        removal_count = static_cast<int>(qMin<quint32>(kTail - kHead, kQueueSize));
+        for (int i = 0; i < removal_count; ++i)
+            removals[i] = m_queue[(kHead + i) & (kQueueSize - 1)].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == kSequence)
+            break;
+    }
+
+    const auto kIsRemoved = [&](const Entry& entry)
+    {
+        for (int i = 0; i < removal_count; ++i)
+        {
+            const auto kClientId = static_cast<anyID>(removals[i] & 0xffff);
+            if ((removals[i] >> 16) == entry.sch_id && (kClientId == kAllClients || kClientId == entry.client_id))
+                return true;
+        }
+        return false;
+    };
+
+    // apply what the next update() would
+    const auto kNow = now_ms();
+    int live_count = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const auto kElapsedMs = kNow - updated_ms[i];
+        if (kElapsedMs > kStaleMs || kIsRemoved(entries[i]))
+            continue;
+
+        entries[live_count] = entries[i];
+        entries[live_count].level_db = qMax(-200.0f, entries[i].level_db - m_release_db_per_s * kElapsedMs / 1000.0f);
+        ++live_count;
+    }
+    count = live_count;
+
+    std::sort(entries.begin(), entries.begin() + count, [](const Entry& a, const Entry& b) { return a.level_db > b.level_db; });
+    count = qMin(count, max_count);
+    std::copy(entries.cbegin(), entries.cbegin() + count, result);
+    return count;
+}
@@ -0,0 +1,190 @@
+#include "volume/voice_activity.h"
+
+#include <chrono>
+
+#include "volume/db.h"
+#include "core/frame_analysis.h"
+
+namespace {
+
+    // Zero crossings of the first channel; branch free so the compiler can vectorize it
+    int count_zero_crossings(const short* samples, int frame_count, int channels)
+    {
+        const auto kCount = frame_count * channels;
+        int crossings = 0;
+        for (int i = channels; i < kCount; i += channels)
+            crossings += ((samples[i] ^ samples[i - channels]) >> 15) & 1;
+
+        return crossings;
+    }
+}
+
+VoiceActivity::VoiceActivity()
+{}
+
+quint32 VoiceActivity::hash(quint64 key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<quint32>(key);
+}
+
+qint64 VoiceActivity::now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writer side lookup; takes the first empty or expired slot of the probe sequence for new keys
+VoiceActivity::Slot* VoiceActivity::acquire(quint64 key, qint64 now_ms)
+{
+    Slot* reusable = nullptr;
+    auto index = hash(key);
+    for (int probe = 0; probe < kCapacity; ++probe, ++index)
+    {
+        auto& slot = m_slots[index & (kCapacity - 1)];
+        const auto kKey = slot.key.load(std::memory_order_relaxed);
+        if (kKey == key)
+            return &slot;
+
+        if (kKey == 0)
+        {
+            if (!reusable)
+                reusable = &slot;
+
+            break;
+        }
+        if (!reusable && (now_ms - slot.updated_ms.load(std::memory_order_relaxed) > kExpireMs))
+            reusable = &slot;
+    }
+    if (!reusable)
+        return nullptr;
+
+    const auto kSequence = reusable->sequence.load(std::memory_order_relaxed);
+    reusable->sequence.store(kSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    reusable->key.store(key, std::memory_order_relaxed);
+    reusable->level_db.store(-200.0f, std::memory_order_relaxed);
+    reusable->peak_db.store(-200.0f, std::memory_order_relaxed);
+    reusable->noise_floor_db.store(-200.0f, std::memory_order_relaxed);
+    reusable->is_speech.store(false, std::memory_order_relaxed);
+    reusable->updated_ms.store(now_ms, std::memory_order_relaxed);
+    reusable->speech_until_ms = 0;
+    reusable->sequence.store(kSequence + 2, std::memory_order_release);
+    return reusable;
+}
+
+const VoiceActivity::Slot* VoiceActivity::find(quint64 key) const
+{
+    auto index = hash(key);
+    for (int probe = 0; probe < kCapacity; ++probe, ++index)
+    {
+        const auto& slot = m_slots[index & (kCapacity - 1)];
+        const auto kKey = slot.key.load(std::memory_order_acquire);
+        if (kKey == key)
+            return &slot;
+
+        if (kKey == 0)
+            break;
+    }
+    return nullptr;
+}
+
+//! Analyze a playback block of a client
+/*!
+ * \brief VoiceActivity::process playback thread only
+ * \param sch_id the server connection
+ * \param client_id the client
+ * \param samples interleaved samples
+ * \param frame_count frames in the block
+ * \param channels channels per frame
+ * \param sample_rate used to scale the envelope time constants
+ * \return false if the table is full
+ */
+bool VoiceActivity::process(uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels, int sample_rate)
+{
+    if (frame_count <= 0 || channels <= 0)
+        return true;
+
+    const auto kNow = now_ms();
+    auto slot = acquire(make_key(sch_id, client_id), kNow);
+    if (!slot)
+        return false;
+
+    // shares the peak / rms pass with the other consumers of this callback
+    const auto kAnalysis = FrameAnalysis::get(samples, frame_count * channels);
+    const auto zero_crossings = count_zero_crossings(samples, frame_count, channels);
+
+    const auto kBlockDb = lin2db(kAnalysis.rms);
+    const auto kPeakDb = lin2db(kAnalysis.peak / 32768.0f);
+    const auto kZcr = (frame_count > 1) ? static_cast<float>(zero_crossings) / (frame_count - 1) : 0.0f;
+    const auto kBlockSeconds = static_cast<float>(frame_count) / sample_rate;
+
+    // envelope: fast attack, slower release
+    auto level_db = slot->level_db.load(std::memory_order_relaxed);
+    if (level_db <= -200.0f || kBlockDb > level_db)
+        level_db = kBlockDb;
+    else
+        level_db = qMax(kBlockDb, level_db - 60.0f * kBlockSeconds);   // 60 dB/s
+
+    // noise floor: follows drops at once, rises slowly so speech doesn't pull it up
+    auto noise_floor_db = slot->noise_floor_db.load(std::memory_order_relaxed);
+    if (noise_floor_db <= -200.0f || kBlockDb < noise_floor_db)
+        noise_floor_db = kBlockDb;
+    else
+        noise_floor_db = qMin(kBlockDb, noise_floor_db + 1.5f * kBlockSeconds);    // 1.5 dB/s
+
+    const bool kIsVoiced = (level_db > m_min_level_db)
+            && (level_db > noise_floor_db + m_snr_db)
+            && (kZcr >= m_min_zcr) && (kZcr <= m_max_zcr);
+    if (kIsVoiced)
+        slot->speech_until_ms = kNow + m_hangover_ms;
+
+    const auto kSequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(kSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->level_db.store(level_db, std::memory_order_relaxed);
+    slot->peak_db.store(kPeakDb, std::memory_order_relaxed);
+    slot->noise_floor_db.store(noise_floor_db, std::memory_order_relaxed);
+    slot->is_speech.store(kNow < slot->speech_until_ms, std::memory_order_relaxed);
+    slot->updated_ms.store(kNow, std::memory_order_relaxed);
+    slot->sequence.store(kSequence + 2, std::memory_order_release);
+    return true;
+}
+
+bool VoiceActivity::get(uint64 sch_id, anyID client_id, Result* result) const
+{
+    const auto kKey = make_key(sch_id, client_id);
+    auto slot = find(kKey);
+    if (!slot)
+        return false;
+
+    for (;;)
+    {
+        const auto kSequence = slot->sequence.load(std::memory_order_acquire);
+        if (kSequence & 1)
+            continue;
+
+        const auto kKeyRead = slot->key.load(std::memory_order_relaxed);
+        result->level_db = slot->level_db.load(std::memory_order_relaxed);
+        result->peak_db = slot->peak_db.load(std::memory_order_relaxed);
+        result->noise_floor_db = slot->noise_floor_db.load(std::memory_order_relaxed);
+        result->is_speech = slot->is_speech.load(std::memory_order_relaxed);
+        const auto kUpdated = slot->updated_ms.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != kSequence)
+            continue;
+
+        if (kKeyRead != kKey)
+            return false;   // reused for another client meanwhile
+
+        result->age_ms = now_ms() - kUpdated;
+        return true;
+    }
+}
+
+bool VoiceActivity::is_speech(uint64 sch_id, anyID client_id) const
+{
+    Result result;
+    return get(sch_id, client_id, &result) && result.is_speech && (result.age_ms < kStaleMs);
+}
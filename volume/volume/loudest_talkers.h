@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <QtCore/QtGlobal>
+
+#include "teamspeak/public_definitions.h"
+
+// The K loudest talkers across all server connections.
+// Fed from the playback callback: update() is O(log K) on an indexed min-heap of the current
+// top K over a fixed table of smoothed per client levels and never blocks or allocates.
+// remove() is for the main thread (talk stopped, disconnect); requests travel through an
+// SPSC queue and are applied by the next update(). top() may be called from any thread (GUI);
+// the heap is guarded by a sequence counter so it copies a consistent view. As update() stops
+// being called once playback stops, top() applies what it would have done itself: it skips
+// clients with a queued remove request or without a block for kStaleMs and releases the levels
+// by the time since each client's last block. Table slots of clients without a block for
+// kExpireMs are reused, so clients that are never remove()d don't fill the table.
+class LoudestTalkers
+{
+
+public:
+    struct Entry
+    {
+        uint64 sch_id = 0;
+        anyID client_id = 0;
+        float level_db = -200.0f;
+    };
+
+    explicit LoudestTalkers(int k = 8);
+
+    // playback thread only
+    void update(uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels, int sample_rate = 48000);
+    void update_level(uint64 sch_id, anyID client_id, float block_db, int frame_count, int sample_rate = 48000);
+
+    // main thread only; false if the queue is full
+    bool remove(uint64 sch_id, anyID client_id);
+    bool remove(uint64 sch_id);
+
+    // any thread; loudest first, returns the number of entries written
+    int top(Entry* result, int max_count) const;
+    int k() const { return m_k; }
+
+    float m_release_db_per_s = 20.0f;
+
+    static const int kCapacity = 1024;  // power of two; clients tracked at once
+    static const int kQueueSize = 256;  // power of two
+    static const int kStaleMs = 500;    // without a block for as long, a client isn't talking anymore
+    static const int kExpireMs = 60000; // without a block for as long, a client's slot may be reused
+
+private:
+    struct Client
+    {
+        std::atomic<quint64> key{0};        // sch_id << 16 | client_id; 0: empty
+        std::atomic<float> level_db{-200.0f};
+        std::atomic<qint64> updated_ms{0};  // of the last block
+        int heap_pos = -1;                  // writer only
+        bool is_tombstone = false;          // writer only
+    };
+    std::array<Client, kCapacity> m_clients;
+
+    const int m_k;
+    std::vector<std::atomic<int> > m_heap;  // client indices, min-heap by level
+    std::atomic<int> m_heap_size{0};
+    std::atomic<quint32> m_sequence{0};
+    qint64 m_expire_ms = 0;                 // writer only
+
+    // remove requests; key with client id 0xffff: whole server
+    std::array<std::atomic<quint64>, kQueueSize> m_queue;
+    std::atomic<quint32> m_queue_head{0};   // written by the consumer
+    std::atomic<quint32> m_queue_tail{0};   // written by the producer
+
+    static quint64 make_key(uint64 sch_id, anyID client_id) { return (sch_id << 16) | client_id; }
+    static quint32 hash(quint64 key);
+    static qint64 now_ms();
+    int find(quint64 key) const;
+    int acquire(quint64 key, qint64 now_ms);
+    void release(int index);
+    void drain();
+    void expire(qint64 now_ms);
+
+    float level(int heap_pos) const;
+    void swap(int a, int b);
+    void sift_up(int pos);
+    void sift_down(int pos);
+    void heap_remove(int pos);
+    void begin_write();
+    void end_write();
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <QtCore/QtGlobal>
+
+#include "teamspeak/public_definitions.h"
+
+// Per client voice activity and level derived from the played back audio.
+// The server talk flag only says a client transmits; this tells speech from open mic noise
+// using an energy envelope against a tracked noise floor plus the zero crossing rate.
+//
+// process() is meant for on_playback_pre_process (peak and rms come from FrameAnalysis) and must be called from one thread only
+// (the playback thread); it neither locks nor allocates. The results live in a fixed size
+// open addressing table whose slots are guarded by a sequence counter, so any thread
+// (ducking, AGC, GUI) can read a consistent result without blocking the writer.
+// Slots of clients silent for kExpireMs are reused.
+class VoiceActivity
+{
+
+public:
+    struct Result
+    {
+        float level_db = -200.0f;       // smoothed rms, dBFS
+        float peak_db = -200.0f;        // last block, dBFS
+        float noise_floor_db = -200.0f;
+        bool is_speech = false;
+        qint64 age_ms = 0;              // since the last block
+    };
+
+    VoiceActivity();
+
+    bool process(uint64 sch_id, anyID client_id, const short* samples, int frame_count, int channels, int sample_rate = 48000);
+
+    bool get(uint64 sch_id, anyID client_id, Result* result) const;
+    bool is_speech(uint64 sch_id, anyID client_id) const;   // false if unknown or stale
+
+    // Tuning; set before audio starts
+    float m_snr_db = 9.0f;              // above the noise floor
+    float m_min_level_db = -55.0f;
+    float m_min_zcr = 0.005f;           // zero crossings per sample; below: hum and rumble
+    float m_max_zcr = 0.35f;            // above: hiss and white noise
+    int m_hangover_ms = 250;
+
+    static const int kCapacity = 1024;      // power of two
+    static const int kExpireMs = 60000;
+    static const int kStaleMs = 500;
+
+private:
+    struct Slot
+    {
+        std::atomic<quint64> key{0};        // 0: empty
+        std::atomic<quint32> sequence{0};   // odd while being written
+        std::atomic<float> level_db{-200.0f};
+        std::atomic<float> peak_db{-200.0f};
+        std::atomic<float> noise_floor_db{-200.0f};
+        std::atomic<bool> is_speech{false};
+        std::atomic<qint64> updated_ms{0};
+
+        // writer only
+        qint64 speech_until_ms = 0;
+    };
+    std::array<Slot, kCapacity> m_slots;
+
+    static quint64 make_key(uint64 sch_id, anyID client_id) { return (sch_id << 16) | client_id; }
+    static quint32 hash(quint64 key);
+    static qint64 now_ms();
+    Slot* acquire(quint64 key, qint64 now_ms);
+    const Slot* find(quint64 key) const;
+};